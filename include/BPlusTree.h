@@ -10,10 +10,13 @@
 #include <algorithm>
 #include <cstddef>
 #include <limits>
+#include "BPlusTreeKeys.h"
 
 // -- PAGE-SIZE SENSITIVITY AND NODE ORDER --
 // User should specify node order (max number of keys) based on hardware or page size at tree construction.
 // For real-world use, page size can be 4KB/8KB/etc, and order is set so a node fits one page.
+// std::string keys are prefix-compressed per node and internal nodes hold truncated separators
+// (see BPlusTreeKeys.h), so long keys cost far fewer bytes per node than the order alone suggests.
 
 template<typename Key, typename Value>
 class BPlusTree {
@@ -27,9 +30,18 @@ public:
 
     void insert(const Key& key, const Value& value);
     std::optional<Value> find(const Key& key) const;
-    void erase(const Key& key);
+    // Removes key if present, rebalancing (borrow/merge) up to the root. Returns true if a key was removed.
+    bool erase(const Key& key);
     std::vector<std::pair<Key, Value>> range(const std::optional<Key>& lower = std::nullopt, const std::optional<Key>& upper = std::nullopt) const;
+    // Streams entries along the leaf chain in key order (descending: from rightmostLeaf_ via prev),
+    // calling fn(key, value) until it returns false. Nothing is copied out up front; string keys are
+    // rebuilt into one buffer, so the key reference is only valid during the call.
+    template<typename Fn>
+    void scan(bool descending, Fn&& fn) const;
     void clear();
+    // Replaces the contents with 'sorted' (strictly increasing keys), building full leaves and then
+    // each internal level bottom-up: O(N) instead of N root-to-leaf inserts. Throws on unsorted input.
+    void bulkLoad(const std::vector<std::pair<Key, Value>>& sorted);
 
     // For diagnostics/monitoring:
     std::size_t size() const;
@@ -58,8 +70,10 @@ private:
         virtual ~Node() = default;
     };
 
+    using Keys = typename NodeKeys<Key>::type;
+
     struct InternalNode : Node {
-        std::vector<Key> keys;
+        Keys keys;
         std::vector<std::unique_ptr<Node>> children;
         InternalNode(std::size_t order)
             : Node(false)
@@ -70,7 +84,7 @@ private:
     };
 
     struct LeafNode : Node {
-        std::vector<Key> keys;
+        Keys keys;
         std::vector<Value> values;
         LeafNode* next;
         LeafNode* prev;
@@ -84,14 +98,14 @@ private:
 
     // -- INSERT, ERASE, & SPLIT/MERGE LOGIC --
     // All insert/erase are recursive and handle split/merge up to root.
-    bool insertRecursive(Node* node, const Key& key, const Value& value, Key& upKey, std::unique_ptr<Node>& newChild, std::size_t curHeight);
+    bool insertRecursive(Node* node, const Key& key, const Value& value, Key& upKey, std::unique_ptr<Node>& newChild, std::size_t curHeight, bool& added);
     bool eraseRecursive(Node* node, const Key& key, std::size_t curHeight, bool& needsMerge);
 
     void splitLeaf(LeafNode* node, std::unique_ptr<LeafNode>& newLeaf, Key& upKey);
     void splitInternal(InternalNode* node, std::unique_ptr<InternalNode>& newNode, Key& upKey);
 
     void mergeLeaves(LeafNode* leftLeaf, LeafNode* rightLeaf);
-    void mergeInternals(InternalNode* leftNode, InternalNode* rightNode, Key& separator);
+    void mergeInternals(InternalNode* leftNode, InternalNode* rightNode, const Key& separator);
 
     std::optional<Value> findRecursive(const Node* node, const Key& key, std::size_t curHeight) const;
     void rangeRecursive(const Node* node,
@@ -102,11 +116,14 @@ private:
     void clearRecursive(std::unique_ptr<Node>& node);
 
     // Used by erase for rebalancing
-    bool borrowFromLeft(Node* parent, std::size_t childIdx, std::size_t curHeight);
-    bool borrowFromRight(Node* parent, std::size_t childIdx, std::size_t curHeight);
+    bool borrowFromLeft(Node* parent, std::size_t childIdx);
+    bool borrowFromRight(Node* parent, std::size_t childIdx);
+    void rebalanceChild(InternalNode* parent, std::size_t childIdx);
 
     // -- UTILITIES --
-    std::size_t findChildIndex(const std::vector<Key>& keys, const Key& key) const;
+    std::size_t findChildIndex(const Keys& keys, const Key& key) const;
+    // Minimum fill of a non-root node; mirrors what a split leaves behind.
+    std::size_t minKeys() const { return std::max<std::size_t>(1, nodeOrder_ / 2); }
 
     // (Optional: support for persistent serialization)
 };
@@ -4,6 +4,7 @@
 #pragma once
 #include "BPlusTree.h"
 #include <stdexcept>
+#include <iterator>
 
 template<typename Key, typename Value>
 BPlusTree<Key, Value>::BPlusTree(std::size_t nodeOrder)
@@ -28,6 +29,66 @@ void BPlusTree<Key, Value>::clear() {
     height_ = 1;
 }
 
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::bulkLoad(const std::vector<std::pair<Key, Value>>& sorted) {
+    for (std::size_t i = 1; i < sorted.size(); ++i) {
+        if (!(sorted[i - 1].first < sorted[i].first))
+            throw std::invalid_argument("BPlusTree::bulkLoad requires strictly increasing keys.");
+    }
+    clear();
+    if (sorted.empty()) return;
+
+    // Spread 'total' entries over as few nodes of at most 'capacity' as possible, evenly, so every
+    // node but a lone root stays at or above minKeys() and erase can rebalance as usual.
+    auto spread = [](std::size_t total, std::size_t capacity) {
+        const std::size_t nodes = (total + capacity - 1) / capacity;
+        std::vector<std::size_t> sizes(nodes, total / nodes);
+        for (std::size_t i = 0; i < total % nodes; ++i) sizes[i]++;
+        return sizes;
+    };
+
+    // Each level as (node, separator from its left neighbour); that separator goes into the parent.
+    std::vector<std::pair<std::unique_ptr<Node>, Key>> level;
+    LeafNode* prev = nullptr;
+    std::size_t pos = 0;
+    for (std::size_t count : spread(sorted.size(), nodeOrder_)) {
+        auto leaf = std::make_unique<LeafNode>(nodeOrder_);
+        Key low = prev ? separatorBetween(sorted[pos - 1].first, sorted[pos].first) : sorted[pos].first;
+        for (std::size_t i = 0; i < count; ++i, ++pos) {
+            leaf->keys.push_back(sorted[pos].first);
+            leaf->values.push_back(sorted[pos].second);
+        }
+        leaf->count = count;
+        leaf->prev = prev;
+        if (prev) prev->next = leaf.get();
+        prev = leaf.get();
+        level.emplace_back(std::move(leaf), std::move(low));
+    }
+    LeafNode* first = static_cast<LeafNode*>(level.front().first.get());
+    std::size_t height = 1;
+    while (level.size() > 1) {
+        std::vector<std::pair<std::unique_ptr<Node>, Key>> parents;
+        std::size_t child = 0;
+        for (std::size_t count : spread(level.size(), nodeOrder_ + 1)) {
+            auto internal = std::make_unique<InternalNode>(nodeOrder_);
+            Key low = level[child].second;
+            for (std::size_t i = 0; i < count; ++i, ++child) {
+                if (i > 0) internal->keys.push_back(std::move(level[child].second));
+                internal->children.push_back(std::move(level[child].first));
+            }
+            internal->count = internal->keys.size();
+            parents.emplace_back(std::move(internal), std::move(low));
+        }
+        level = std::move(parents);
+        height++;
+    }
+    root_ = std::move(level.front().first);
+    leftmostLeaf_ = first;
+    rightmostLeaf_ = prev;
+    size_ = sorted.size();
+    height_ = height;
+}
+
 template<typename Key, typename Value>
 void BPlusTree<Key, Value>::insert(const Key& key, const Value& value) {
     if constexpr (!std::is_copy_constructible_v<Value>) {
@@ -35,7 +96,8 @@ void BPlusTree<Key, Value>::insert(const Key& key, const Value& value) {
     }
     Key upKey;
     std::unique_ptr<Node> newChild;
-    if (insertRecursive(root_.get(), key, value, upKey, newChild, height_)) {
+    bool added = false;
+    if (insertRecursive(root_.get(), key, value, upKey, newChild, height_, added)) {
         // Node split reached root
         auto newRoot = std::make_unique<InternalNode>(nodeOrder_);
         newRoot->keys.push_back(upKey);
@@ -44,22 +106,22 @@ void BPlusTree<Key, Value>::insert(const Key& key, const Value& value) {
         root_ = std::move(newRoot);
         height_++;
     }
-    size_++;
+    if (added) size_++;
 }
 
 template<typename Key, typename Value>
-bool BPlusTree<Key, Value>::insertRecursive(Node* node, const Key& key, const Value& value, Key& upKey, std::unique_ptr<Node>& newChild, std::size_t curHeight) {
+bool BPlusTree<Key, Value>::insertRecursive(Node* node, const Key& key, const Value& value, Key& upKey, std::unique_ptr<Node>& newChild, std::size_t curHeight, bool& added) {
     if (node->isLeaf) {
         auto* leaf = static_cast<LeafNode*>(node);
-        auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
-        auto idx = std::distance(leaf->keys.begin(), it);
-        if (it != leaf->keys.end() && *it == key) {
+        auto idx = leaf->keys.lowerBound(key);
+        if (idx < leaf->keys.size() && leaf->keys.equals(idx, key)) {
             leaf->values[idx] = value;
             return false;
         }
-        leaf->keys.insert(it, key);
+        leaf->keys.insert(idx, key);
         leaf->values.insert(leaf->values.begin() + idx, value);
         leaf->count++;
+        added = true;
         if (leaf->keys.size() > nodeOrder_) {
             std::unique_ptr<LeafNode> newLeaf = std::make_unique<LeafNode>(nodeOrder_);
             splitLeaf(leaf, newLeaf, upKey);
@@ -78,8 +140,8 @@ bool BPlusTree<Key, Value>::insertRecursive(Node* node, const Key& key, const Va
         auto idx = findChildIndex(internal->keys, key);
         Key childUpKey;
         std::unique_ptr<Node> childNewChild;
-        if (insertRecursive(internal->children[idx].get(), key, value, childUpKey, childNewChild, curHeight - 1)) {
-            internal->keys.insert(internal->keys.begin() + idx, childUpKey);
+        if (insertRecursive(internal->children[idx].get(), key, value, childUpKey, childNewChild, curHeight - 1, added)) {
+            internal->keys.insert(idx, childUpKey);
             internal->children.insert(internal->children.begin() + idx + 1, std::move(childNewChild));
             internal->count++;
             if (internal->keys.size() > nodeOrder_) {
@@ -96,30 +158,177 @@ bool BPlusTree<Key, Value>::insertRecursive(Node* node, const Key& key, const Va
 template<typename Key, typename Value>
 void BPlusTree<Key, Value>::splitLeaf(LeafNode* node, std::unique_ptr<LeafNode>& newLeaf, Key& upKey) {
     std::size_t mid = node->keys.size() / 2;
-    newLeaf->keys.assign(node->keys.begin() + mid, node->keys.end());
+    node->keys.splitTo(mid, newLeaf->keys);
     newLeaf->values.assign(node->values.begin() + mid, node->values.end());
     newLeaf->count = newLeaf->keys.size();
-    node->keys.resize(mid);
     node->values.resize(mid);
     node->count = node->keys.size();
-    upKey = newLeaf->keys.front();
+    upKey = separatorBetween(node->keys.back(), newLeaf->keys.front());
 }
 
 template<typename Key, typename Value>
 void BPlusTree<Key, Value>::splitInternal(InternalNode* node, std::unique_ptr<InternalNode>& newNode, Key& upKey) {
     std::size_t mid = node->keys.size() / 2;
     upKey = node->keys[mid];
-    newNode->keys.assign(node->keys.begin() + mid + 1, node->keys.end());
+    node->keys.splitTo(mid + 1, newNode->keys);
+    node->keys.pop_back();
     newNode->children.reserve(node->children.size() - (mid + 1));
     for (auto it = node->children.begin() + mid + 1; it != node->children.end(); ++it) {
         newNode->children.push_back(std::move(*it));
     }
     newNode->count = newNode->keys.size();
-    node->keys.resize(mid);
     node->children.resize(mid + 1);
     node->count = node->keys.size();
 }
 
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::erase(const Key& key) {
+    bool needsMerge = false;
+    if (!eraseRecursive(root_.get(), key, height_, needsMerge))
+        return false;
+    // Collapse a root that lost its last separator; the tree shrinks by one level.
+    if (!root_->isLeaf) {
+        auto* internal = static_cast<InternalNode*>(root_.get());
+        if (internal->keys.empty()) {
+            std::unique_ptr<Node> child = std::move(internal->children.front());
+            root_ = std::move(child);
+            height_--;
+        }
+    }
+    size_--;
+    return true;
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::eraseRecursive(Node* node, const Key& key, std::size_t curHeight, bool& needsMerge) {
+    if (node->isLeaf) {
+        auto* leaf = static_cast<LeafNode*>(node);
+        auto idx = leaf->keys.lowerBound(key);
+        if (idx == leaf->keys.size() || !leaf->keys.equals(idx, key))
+            return false;
+        leaf->keys.erase(idx);
+        leaf->values.erase(leaf->values.begin() + idx);
+        leaf->count--;
+        needsMerge = leaf->keys.size() < minKeys();
+        return true;
+    }
+    auto* internal = static_cast<InternalNode*>(node);
+    auto idx = findChildIndex(internal->keys, key);
+    bool childNeedsMerge = false;
+    if (!eraseRecursive(internal->children[idx].get(), key, curHeight - 1, childNeedsMerge))
+        return false;
+    if (childNeedsMerge)
+        rebalanceChild(internal, idx);
+    needsMerge = internal->keys.size() < minKeys();
+    return true;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::rebalanceChild(InternalNode* parent, std::size_t childIdx) {
+    if (borrowFromLeft(parent, childIdx) || borrowFromRight(parent, childIdx))
+        return;
+    // Neither sibling can spare a key: merge with one of them (prefer left) and drop the separator.
+    std::size_t leftIdx = childIdx > 0 ? childIdx - 1 : childIdx;
+    Node* left = parent->children[leftIdx].get();
+    Node* right = parent->children[leftIdx + 1].get();
+    if (left->isLeaf) {
+        mergeLeaves(static_cast<LeafNode*>(left), static_cast<LeafNode*>(right));
+    } else {
+        mergeInternals(static_cast<InternalNode*>(left), static_cast<InternalNode*>(right), parent->keys[leftIdx]);
+    }
+    parent->keys.erase(leftIdx);
+    parent->children.erase(parent->children.begin() + leftIdx + 1);
+    parent->count--;
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::borrowFromLeft(Node* parent, std::size_t childIdx) {
+    if (childIdx == 0) return false;
+    auto* p = static_cast<InternalNode*>(parent);
+    Node* child = p->children[childIdx].get();
+    Node* sibling = p->children[childIdx - 1].get();
+    if (sibling->count <= minKeys()) return false;
+
+    if (child->isLeaf) {
+        auto* leaf = static_cast<LeafNode*>(child);
+        auto* left = static_cast<LeafNode*>(sibling);
+        leaf->keys.insert(0, left->keys.back());
+        leaf->values.insert(leaf->values.begin(), std::move(left->values.back()));
+        left->keys.pop_back();
+        left->values.pop_back();
+        p->keys.set(childIdx - 1, separatorBetween(left->keys.back(), leaf->keys.front()));
+    } else {
+        auto* node = static_cast<InternalNode*>(child);
+        auto* left = static_cast<InternalNode*>(sibling);
+        // Rotate right through the parent: separator comes down, left's last key goes up.
+        node->keys.insert(0, p->keys[childIdx - 1]);
+        node->children.insert(node->children.begin(), std::move(left->children.back()));
+        p->keys.set(childIdx - 1, left->keys.back());
+        left->keys.pop_back();
+        left->children.pop_back();
+    }
+    child->count++;
+    sibling->count--;
+    return true;
+}
+
+template<typename Key, typename Value>
+bool BPlusTree<Key, Value>::borrowFromRight(Node* parent, std::size_t childIdx) {
+    auto* p = static_cast<InternalNode*>(parent);
+    if (childIdx + 1 >= p->children.size()) return false;
+    Node* child = p->children[childIdx].get();
+    Node* sibling = p->children[childIdx + 1].get();
+    if (sibling->count <= minKeys()) return false;
+
+    if (child->isLeaf) {
+        auto* leaf = static_cast<LeafNode*>(child);
+        auto* right = static_cast<LeafNode*>(sibling);
+        leaf->keys.push_back(right->keys.front());
+        leaf->values.push_back(std::move(right->values.front()));
+        right->keys.erase(0);
+        right->values.erase(right->values.begin());
+        p->keys.set(childIdx, separatorBetween(leaf->keys.back(), right->keys.front()));
+    } else {
+        auto* node = static_cast<InternalNode*>(child);
+        auto* right = static_cast<InternalNode*>(sibling);
+        // Rotate left through the parent: separator comes down, right's first key goes up.
+        node->keys.push_back(p->keys[childIdx]);
+        node->children.push_back(std::move(right->children.front()));
+        p->keys.set(childIdx, right->keys.front());
+        right->keys.erase(0);
+        right->children.erase(right->children.begin());
+    }
+    child->count++;
+    sibling->count--;
+    return true;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::mergeLeaves(LeafNode* leftLeaf, LeafNode* rightLeaf) {
+    leftLeaf->keys.append(std::move(rightLeaf->keys));
+    std::move(rightLeaf->values.begin(), rightLeaf->values.end(), std::back_inserter(leftLeaf->values));
+    leftLeaf->count = leftLeaf->keys.size();
+    // Unlink rightLeaf from the leaf chain; its owner (the parent) destroys it.
+    leftLeaf->next = rightLeaf->next;
+    if (rightLeaf->next) rightLeaf->next->prev = leftLeaf;
+    if (rightmostLeaf_ == rightLeaf) rightmostLeaf_ = leftLeaf;
+    rightLeaf->keys.clear();
+    rightLeaf->values.clear();
+    rightLeaf->count = 0;
+}
+
+template<typename Key, typename Value>
+void BPlusTree<Key, Value>::mergeInternals(InternalNode* leftNode, InternalNode* rightNode, const Key& separator) {
+    leftNode->keys.push_back(separator);
+    leftNode->keys.append(std::move(rightNode->keys));
+    for (auto& child : rightNode->children)
+        leftNode->children.push_back(std::move(child));
+    leftNode->count = leftNode->keys.size();
+    rightNode->keys.clear();
+    rightNode->children.clear();
+    rightNode->count = 0;
+}
+
 template<typename Key, typename Value>
 std::optional<Value> BPlusTree<Key, Value>::find(const Key& key) const {
     if (!root_) throw std::runtime_error("Cannot find in an empty BPlusTree.");
@@ -130,9 +339,9 @@ template<typename Key, typename Value>
 std::optional<Value> BPlusTree<Key, Value>::findRecursive(const Node* node, const Key& key, std::size_t curHeight) const {
     if (node->isLeaf) {
         auto* leaf = static_cast<const LeafNode*>(node);
-        auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
-        if (it != leaf->keys.end() && *it == key) {
-            return leaf->values[std::distance(leaf->keys.begin(), it)];
+        auto idx = leaf->keys.lowerBound(key);
+        if (idx < leaf->keys.size() && leaf->keys.equals(idx, key)) {
+            return leaf->values[idx];
         }
         return std::nullopt;
     } else {
@@ -153,10 +362,10 @@ std::size_t BPlusTree<Key, Value>::height() const {
 }
 
 template<typename Key, typename Value>
-std::size_t BPlusTree<Key, Value>::findChildIndex(const std::vector<Key>& keys, const Key& key) const {
+std::size_t BPlusTree<Key, Value>::findChildIndex(const Keys& keys, const Key& key) const {
     // Find the first key > 'key'
     if (keys.empty()) throw std::runtime_error("Invalid operation: children index on empty keys vector in BPlusTree.");
-    return std::distance(keys.begin(), std::upper_bound(keys.begin(), keys.end(), key));
+    return keys.upperBound(key);
 }
 
 template<typename Key, typename Value>
@@ -165,20 +374,37 @@ std::vector<std::pair<Key, Value>> BPlusTree<Key, Value>::range(const std::optio
 {
     std::vector<std::pair<Key, Value>> out;
     LeafNode* leaf = leftmostLeaf_;
-    // Advance to lower bound:
+    // Advance to lower bound; the bounds are searched in each leaf, so keys are only copied to be returned.
     while (leaf) {
-        auto it = lower ? std::lower_bound(leaf->keys.begin(), leaf->keys.end(), *lower) : leaf->keys.begin();
-        for (; it != leaf->keys.end(); ++it) {
-            auto idx = std::distance(leaf->keys.begin(), it);
-            if (upper && *it >= *upper)
-                return out;
-            out.emplace_back(*it, leaf->values[idx]);
-        }
+        const std::size_t end = upper ? leaf->keys.lowerBound(*upper) : leaf->keys.size();
+        for (std::size_t idx = lower ? leaf->keys.lowerBound(*lower) : 0; idx < end; ++idx)
+            out.emplace_back(leaf->keys[idx], leaf->values[idx]);
+        if (end < leaf->keys.size())
+            return out;
         leaf = leaf->next;
     }
     return out;
 }
 
+template<typename Key, typename Value>
+template<typename Fn>
+void BPlusTree<Key, Value>::scan(bool descending, Fn&& fn) const {
+    Key scratch{};
+    if (descending) {
+        for (const LeafNode* leaf = rightmostLeaf_; leaf; leaf = leaf->prev) {
+            for (std::size_t idx = leaf->keys.size(); idx-- > 0;) {
+                if (!fn(leaf->keys.at(idx, scratch), leaf->values[idx])) return;
+            }
+        }
+        return;
+    }
+    for (const LeafNode* leaf = leftmostLeaf_; leaf; leaf = leaf->next) {
+        for (std::size_t idx = 0; idx < leaf->keys.size(); ++idx) {
+            if (!fn(leaf->keys.at(idx, scratch), leaf->values[idx])) return;
+        }
+    }
+}
+
 template<typename Key, typename Value>
 void BPlusTree<Key, Value>::clearRecursive(std::unique_ptr<Node>& node) {
     if (!node) return;
@@ -0,0 +1,223 @@
+// BPlusTreeKeys.h
+// Key storage for BPlusTree nodes.
+//
+// Every node keeps its sorted keys in a NodeKeys<Key>: a plain std::vector for most key types,
+// and PrefixKeys for std::string. PrefixKeys stores the prefix shared by every key of the node
+// once and the remaining suffixes back to back in one buffer, so nodes of long keys with common
+// prefixes (URLs, tenant-prefixed ids, encoded composite keys) stay small and a search compares
+// suffixes only. Both expose the same index-based interface, which is all BPlusTree.tpp uses.
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template<typename Key>
+class VectorKeys {
+public:
+    [[nodiscard]] std::size_t size() const { return keys.size(); }
+    [[nodiscard]] bool empty() const { return keys.empty(); }
+    void reserve(std::size_t n) { keys.reserve(n); }
+    void clear() { keys.clear(); }
+
+    const Key& operator[](std::size_t i) const { return keys[i]; }
+    // Key i without a copy ('scratch' is for key types that have to be rebuilt).
+    const Key& at(std::size_t i, Key&) const { return keys[i]; }
+    const Key& front() const { return keys.front(); }
+    const Key& back() const { return keys.back(); }
+    [[nodiscard]] bool equals(std::size_t i, const Key& key) const { return keys[i] == key; }
+
+    // Index of the first key >= key / > key.
+    [[nodiscard]] std::size_t lowerBound(const Key& key) const {
+        return std::distance(keys.begin(), std::lower_bound(keys.begin(), keys.end(), key));
+    }
+    [[nodiscard]] std::size_t upperBound(const Key& key) const {
+        return std::distance(keys.begin(), std::upper_bound(keys.begin(), keys.end(), key));
+    }
+
+    void insert(std::size_t i, Key key) { keys.insert(keys.begin() + i, std::move(key)); }
+    void erase(std::size_t i) { keys.erase(keys.begin() + i); }
+    void push_back(Key key) { keys.push_back(std::move(key)); }
+    void pop_back() { keys.pop_back(); }
+    void set(std::size_t i, Key key) { keys[i] = std::move(key); }
+    // Keeps the first n keys.
+    void truncate(std::size_t n) { keys.erase(keys.begin() + n, keys.end()); }
+    // Moves keys [from, size()) into 'out' (replacing its contents).
+    void splitTo(std::size_t from, VectorKeys& out) {
+        out.keys.assign(std::make_move_iterator(keys.begin() + from), std::make_move_iterator(keys.end()));
+        truncate(from);
+    }
+    void append(VectorKeys&& other) {
+        std::move(other.keys.begin(), other.keys.end(), std::back_inserter(keys));
+        other.keys.clear();
+    }
+
+private:
+    std::vector<Key> keys;
+};
+
+class PrefixKeys {
+public:
+    [[nodiscard]] std::size_t size() const { return ends.size(); }
+    [[nodiscard]] bool empty() const { return ends.empty(); }
+    void reserve(std::size_t n) { ends.reserve(n); }
+    void clear() {
+        prefix.clear();
+        suffixes.clear();
+        ends.clear();
+    }
+
+    // Keys are rebuilt from prefix + suffix, so these return a new string: for node edits, which
+    // keep the key. Scans use at(), searches and equals() compare the suffixes in place.
+    std::string operator[](std::size_t i) const {
+        std::string key;
+        at(i, key);
+        return key;
+    }
+    // Rebuilds key i into 'scratch', reusing its capacity, so a scan allocates once rather than per key.
+    const std::string& at(std::size_t i, std::string& scratch) const {
+        scratch.assign(prefix).append(suffix(i));
+        return scratch;
+    }
+    std::string front() const { return (*this)[0]; }
+    std::string back() const { return (*this)[size() - 1]; }
+    [[nodiscard]] bool equals(std::size_t i, std::string_view key) const {
+        return key.size() == prefix.size() + length(i) && key.starts_with(prefix) &&
+               key.substr(prefix.size()) == suffix(i);
+    }
+    // Bytes shared by every key in the node (diagnostics).
+    [[nodiscard]] std::size_t prefixLength() const { return prefix.size(); }
+
+    [[nodiscard]] std::size_t lowerBound(std::string_view key) const {
+        return search(key, [](std::string_view s, std::string_view k) { return s < k; });
+    }
+    [[nodiscard]] std::size_t upperBound(std::string_view key) const {
+        return search(key, [](std::string_view s, std::string_view k) { return s <= k; });
+    }
+
+    void insert(std::size_t i, std::string_view key) {
+        if (empty()) {
+            prefix.assign(key);
+        } else if (!key.starts_with(prefix)) {
+            const auto common = std::mismatch(prefix.begin(), prefix.end(), key.begin(), key.end()).first;
+            shrinkPrefix(static_cast<std::size_t>(common - prefix.begin()));
+        }
+        const auto tail = key.substr(prefix.size());
+        suffixes.insert(start(i), tail);
+        ends.insert(ends.begin() + i, static_cast<std::uint32_t>(start(i) + tail.size()));
+        for (std::size_t j = i + 1; j < ends.size(); ++j) ends[j] += static_cast<std::uint32_t>(tail.size());
+    }
+    void erase(std::size_t i) {
+        const std::size_t removed = length(i);
+        suffixes.erase(start(i), removed);
+        ends.erase(ends.begin() + i);
+        for (std::size_t j = i; j < ends.size(); ++j) ends[j] -= static_cast<std::uint32_t>(removed);
+        if (i == 0 || i == ends.size()) growPrefix();
+    }
+    void push_back(std::string_view key) { insert(size(), key); }
+    void pop_back() { erase(size() - 1); }
+    void set(std::size_t i, std::string_view key) {
+        const std::string copy(key);    // key may view this node's own storage
+        erase(i);
+        insert(i, copy);
+    }
+    void truncate(std::size_t n) {
+        suffixes.resize(start(n));
+        ends.resize(n);
+        growPrefix();
+    }
+    void splitTo(std::size_t from, PrefixKeys& out) {
+        const std::size_t offset = start(from);
+        out.prefix = prefix;
+        out.suffixes.assign(suffixes, offset);
+        out.ends.clear();
+        for (std::size_t j = from; j < ends.size(); ++j)
+            out.ends.push_back(ends[j] - static_cast<std::uint32_t>(offset));
+        out.growPrefix();
+        truncate(from);
+    }
+    void append(PrefixKeys&& other) {
+        for (std::size_t j = 0; j < other.size(); ++j) push_back(other[j]);
+        other.clear();
+    }
+
+private:
+    std::string prefix;                 // shared by every key in the node
+    std::string suffixes;               // the rest of each key, back to back
+    std::vector<std::uint32_t> ends;    // ends[i]: end of key i's suffix in 'suffixes'
+
+    [[nodiscard]] std::size_t start(std::size_t i) const { return i ? ends[i - 1] : 0; }
+    [[nodiscard]] std::size_t length(std::size_t i) const { return ends[i] - start(i); }
+    [[nodiscard]] std::string_view suffix(std::size_t i) const {
+        return std::string_view(suffixes).substr(start(i), length(i));
+    }
+
+    // First index whose suffix fails before(suffix, key); the prefix settles keys outside the node's span.
+    template<typename Before>
+    std::size_t search(std::string_view key, Before before) const {
+        const auto head = key.substr(0, prefix.size());
+        if (head != prefix) return head < prefix ? 0 : size();
+        key.remove_prefix(prefix.size());
+        std::size_t lo = 0, hi = size();
+        while (lo < hi) {
+            const std::size_t mid = (lo + hi) / 2;
+            if (before(suffix(mid), key)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Moves prefix bytes [len, ...) back into every suffix.
+    void shrinkPrefix(std::size_t len) {
+        const std::string_view moved = std::string_view(prefix).substr(len);
+        rebuild(moved, 0);
+        prefix.resize(len);
+    }
+
+    // Keys are sorted, so what the first and last suffix share is shared by all of them.
+    void growPrefix() {
+        if (empty()) {
+            prefix.clear();
+            return;
+        }
+        const auto first = suffix(0), last = suffix(size() - 1);
+        const std::size_t extra = static_cast<std::size_t>(
+            std::mismatch(first.begin(), first.end(), last.begin(), last.end()).first - first.begin());
+        if (extra == 0) return;
+        prefix.append(first.substr(0, extra));
+        rebuild({}, extra);
+    }
+
+    // Rewrites every suffix as head + suffix minus its first 'drop' bytes.
+    void rebuild(std::string_view head, std::size_t drop) {
+        std::string rebuilt;
+        rebuilt.reserve(suffixes.size() + head.size() * ends.size());
+        std::size_t from = 0;
+        for (auto& end : ends) {
+            rebuilt.append(head).append(suffixes, from + drop, end - from - drop);
+            from = end;
+            end = static_cast<std::uint32_t>(rebuilt.size());
+        }
+        suffixes = std::move(rebuilt);
+    }
+};
+
+template<typename Key>
+struct NodeKeys { using type = VectorKeys<Key>; };
+template<>
+struct NodeKeys<std::string> { using type = PrefixKeys; };
+
+// Separator to route between two adjacent leaves: every key <= left goes left, every key >= right
+// goes right. Generic keys use 'right'; strings use its shortest prefix that still sorts above
+// 'left', so internal nodes hold truncated separators.
+template<typename Key>
+Key separatorBetween(const Key&, const Key& right) { return right; }
+
+inline std::string separatorBetween(const std::string& left, const std::string& right) {
+    const auto common = std::mismatch(left.begin(), left.end(), right.begin(), right.end()).second;
+    return right.substr(0, static_cast<std::size_t>(common - right.begin()) + 1);
+}
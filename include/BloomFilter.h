@@ -0,0 +1,102 @@
+// Cache-blocked Bloom filter: each key maps to one 512-bit block (one cache line) and sets
+// its k probe bits inside it, so a lookup touches a single line. Hashes are computed by the
+// caller with the bloomHash helpers below, which are stable across platforms because the
+// filter bits are persisted in the database file.
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// splitmix64 finalizer: spreads every input bit over the whole word.
+inline std::uint64_t bloomMix(std::uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline std::uint64_t bloomHash(std::uint64_t v) { return bloomMix(v + 0x9e3779b97f4a7c15ULL); }
+
+// FNV-1a over the bytes, then mixed; std::hash is not stable across standard libraries.
+inline std::uint64_t bloomHash(std::string_view s) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) { h ^= c; h *= 0x100000001b3ULL; }
+    return bloomMix(h);
+}
+
+class BlockedBloomFilter {
+public:
+    static constexpr std::size_t kWordsPerBlock = 8;                  // 8 x 64 = 512 bits
+    static constexpr std::size_t kBitsPerBlock = kWordsPerBlock * 64;
+
+    BlockedBloomFilter() = default;
+    // Sized for 'expectedKeys' at 'bitsPerKey'; k is chosen as round(bitsPerKey * ln 2).
+    BlockedBloomFilter(std::size_t expectedKeys, std::size_t bitsPerKey)
+        : keyCapacity(std::max<std::size_t>(expectedKeys, 1)),
+          probes(static_cast<std::uint8_t>(std::clamp<long>(std::lround(static_cast<double>(bitsPerKey) * 0.6931), 1, 16)))
+    {
+        std::size_t blocks = (keyCapacity * std::max<std::size_t>(bitsPerKey, 1) + kBitsPerBlock - 1) / kBitsPerBlock;
+        words.assign(std::max<std::size_t>(blocks, 1) * kWordsPerBlock, 0);
+    }
+
+    // Rebuilds a filter from persisted state.
+    BlockedBloomFilter(std::size_t capacity, std::uint8_t probeCount, std::vector<std::uint64_t> bits)
+        : words(std::move(bits)), keyCapacity(capacity), probes(probeCount) {}
+
+    void add(std::uint64_t hash) {
+        std::uint64_t* block = blockFor(hash);
+        forEachProbe(hash, [&](std::uint32_t bit) { block[bit >> 6] |= 1ULL << (bit & 63); });
+        keys++;
+    }
+
+    [[nodiscard]] bool mayContain(std::uint64_t hash) const {
+        if (words.empty()) return true;
+        const std::uint64_t* block = blockFor(hash);
+        bool hit = true;
+        forEachProbe(hash, [&](std::uint32_t bit) { hit &= (block[bit >> 6] >> (bit & 63)) & 1; });
+        return hit;
+    }
+
+    // For a restored filter: its bits already cover 'count' keys, so they need not be added again.
+    void setKeyCount(std::size_t count) { keys = count; }
+
+    [[nodiscard]] bool empty() const { return words.empty(); }
+    // Keys added since construction (duplicates included); compared to capacity() to decide on a rebuild.
+    [[nodiscard]] std::size_t keyCount() const { return keys; }
+    [[nodiscard]] std::size_t capacity() const { return keyCapacity; }
+    [[nodiscard]] std::uint8_t probeCount() const { return probes; }
+    [[nodiscard]] const std::vector<std::uint64_t>& bits() const { return words; }
+
+private:
+    std::vector<std::uint64_t> words;
+    std::size_t keyCapacity = 0;
+    std::size_t keys = 0;
+    std::uint8_t probes = 0;
+
+    std::uint64_t* blockFor(std::uint64_t hash) {
+        return words.data() + blockIndex(hash) * kWordsPerBlock;
+    }
+    const std::uint64_t* blockFor(std::uint64_t hash) const {
+        return words.data() + blockIndex(hash) * kWordsPerBlock;
+    }
+    // High 32 bits pick the block (multiply-shift range reduction, no modulo).
+    std::size_t blockIndex(std::uint64_t hash) const {
+        const std::uint64_t blocks = words.size() / kWordsPerBlock;
+        return static_cast<std::size_t>(((hash >> 32) * blocks) >> 32);
+    }
+    // Low 32 bits drive double hashing for the in-block bit positions.
+    template<typename Fn>
+    void forEachProbe(std::uint64_t hash, Fn&& fn) const {
+        std::uint32_t h1 = static_cast<std::uint32_t>(hash);
+        std::uint32_t h2 = (h1 >> 17) | (h1 << 15) | 1;
+        for (std::uint8_t i = 0; i < probes; ++i) {
+            fn(h1 % kBitsPerBlock);
+            h1 += h2;
+        }
+    }
+};
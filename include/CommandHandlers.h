@@ -4,24 +4,27 @@
 
 #pragma once
 #include "CommandType.h"
+#include <array>
 #include <functional>
-#include <unordered_map>
-#include <vector>
-#include <string>
+#include <span>
+#include <string_view>
 #include <iostream>
 
-using CommandHandler = std::function<void(const std::vector<std::string>& args)>;
+// Handlers see views into the current input line; they are valid only for the duration of the call.
+using CommandArgs = std::span<const std::string_view>;
+using CommandHandler = std::function<void(CommandArgs args)>;
 
 class CommandDispatcher {
-    std::unordered_map<CommandType, CommandHandler> handlers;
+    // Indexed by CommandType: dispatch is an array load plus one indirect call.
+    std::array<CommandHandler, static_cast<std::size_t>(CommandType::Invalid) + 1> handlers;
 public:
     void registerHandler(CommandType type, CommandHandler handler) {
-        handlers[type] = std::move(handler);
+        handlers[static_cast<std::size_t>(type)] = std::move(handler);
     }
-    void dispatch(CommandType type, const std::vector<std::string>& args) const {
-        auto it = handlers.find(type);
-        if (it != handlers.end())
-            it->second(args);
+    void dispatch(CommandType type, CommandArgs args) const {
+        const auto& handler = handlers[static_cast<std::size_t>(type)];
+        if (handler)
+            handler(args);
         else
             std::cout << "Unknown command or not implemented yet.\n";
     }
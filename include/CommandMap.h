@@ -3,23 +3,59 @@
 //
 #pragma once
 #include "CommandType.h"
-#include <unordered_map>
+#include <span>
+#include <string_view>
 
-inline const std::unordered_map<std::string, CommandType> CommandMap = {
-    {"create",       CommandType::Create},
-    {"load",         CommandType::Load},
-    {"create_table", CommandType::CreateTable},
-    {"insert",       CommandType::Insert},
-    {"select",       CommandType::Select},
-    {"exit",         CommandType::Exit},
-    {"help",         CommandType::Help}
-};
+// ASCII case-insensitive compare against a lowercase literal; no allocation.
+inline bool equalsLower(std::string_view word, std::string_view lower) {
+    if (word.size() != lower.size()) return false;
+    for (std::size_t i = 0; i < word.size(); ++i) {
+        char c = word[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != lower[i]) return false;
+    }
+    return true;
+}
+
+// Keyword lookup: the length selects a handful of candidates, so each word costs at most a few compares.
+inline CommandType lookupCommand(std::string_view cmd) {
+    switch (cmd.size()) {
+        case 4:
+            if (equalsLower(cmd, "load")) return CommandType::Load;
+            if (equalsLower(cmd, "exit")) return CommandType::Exit;
+            if (equalsLower(cmd, "help")) return CommandType::Help;
+            break;
+        case 5:
+            if (equalsLower(cmd, "bloom")) return CommandType::Bloom;
+            if (equalsLower(cmd, "zones")) return CommandType::Zones;
+            break;
+        case 6:
+            if (equalsLower(cmd, "insert")) return CommandType::Insert;
+            if (equalsLower(cmd, "select")) return CommandType::Select;
+            if (equalsLower(cmd, "create")) return CommandType::Create;
+            if (equalsLower(cmd, "delete")) return CommandType::Delete;
+            if (equalsLower(cmd, "update")) return CommandType::Update;
+            break;
+        case 10:
+            if (equalsLower(cmd, "checkpoint")) return CommandType::Checkpoint;
+            break;
+        case 12:
+            if (equalsLower(cmd, "create_table")) return CommandType::CreateTable;
+            break;
+        case 17:
+            if (equalsLower(cmd, "checkpoint_status")) return CommandType::CheckpointStatus;
+            break;
+        default:
+            break;
+    }
+    return CommandType::Invalid;
+}
 
-inline CommandType parseCommand(const std::string& cmd, const std::vector<std::string>& args = {}) {
+inline CommandType parseCommand(std::string_view cmd, std::span<const std::string_view> args = {}) {
+    CommandType type = lookupCommand(cmd);
     // Special handling: select ... where ...
-    if (cmd == "select" && args.size() > 2 && args[1] == "where") {
+    if (type == CommandType::Select && args.size() > 2 && args[1] == "where") {
         return CommandType::SelectWhere;
     }
-    auto it = CommandMap.find(cmd);
-    return (it != CommandMap.end()) ? it->second : CommandType::Invalid;
+    return type;
 }
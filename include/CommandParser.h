@@ -0,0 +1,94 @@
+// Allocation-free tokenizing and literal parsing for the CLI. Tokens are views into the
+// caller's line buffer, so both the buffer and the token vector can be reused per line.
+
+#pragma once
+#include <charconv>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Table.h"
+
+// Splits 'line' on spaces/tabs into 'tokens' (cleared first; capacity is kept).
+inline void tokenize(std::string_view line, std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    std::size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) ++pos;
+        std::size_t start = pos;
+        while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') ++pos;
+        if (pos > start) tokens.push_back(line.substr(start, pos - start));
+    }
+}
+
+// "key=value" -> {key, value}; nullopt if there is no '='.
+inline std::optional<std::pair<std::string_view, std::string_view>> splitKeyValue(std::string_view arg) {
+    auto eqPos = arg.find('=');
+    if (eqPos == std::string_view::npos) return std::nullopt;
+    return std::pair{arg.substr(0, eqPos), arg.substr(eqPos + 1)};
+}
+
+// Converts a CLI literal to a Value of the column's type. Throws std::invalid_argument on malformed input.
+inline Value parseValue(const Column& col, std::string_view text) {
+    if (col.type == DataType::String) return std::string(text);
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    // from_chars takes no '+'; skip one, but not in front of a sign ("+-5" stays malformed).
+    if (first != last && *first == '+' && (first + 1 == last || first[1] != '-')) ++first;
+    if (col.type == DataType::Integer) {
+        int v = 0;
+        auto [ptr, ec] = std::from_chars(first, last, v);
+        if (ec != std::errc{} || ptr != last || first == last)
+            throw std::invalid_argument("Invalid int for column " + col.name + ": " + std::string(text));
+        return v;
+    }
+    float f = 0.0f;
+    auto [ptr, ec] = std::from_chars(first, last, f);
+    if (ec != std::errc{} || ptr != last || first == last)
+        throw std::invalid_argument("Invalid float for column " + col.name + ": " + std::string(text));
+    return f;
+}
+
+inline const Column* findColumn(const TableSchema& schema, std::string_view name) {
+    for (const auto& col : schema.getColumns()) {
+        if (col.name == name) return &col;
+    }
+    return nullptr;
+}
+
+// Builds a record from "<col>=<val>" tokens, one per schema column. Unknown keys are ignored
+// and later duplicates win. Throws std::runtime_error naming the first missing column.
+inline Record parseRecord(const TableSchema& schema, std::span<const std::string_view> assignments) {
+    Record record;
+    record.reserve(schema.getColumns().size());
+    for (const auto& col : schema.getColumns()) {
+        std::optional<std::string_view> text;
+        for (auto arg : assignments) {
+            auto kv = splitKeyValue(arg);
+            if (kv && kv->first == col.name) text = kv->second;
+        }
+        if (!text) throw std::runtime_error("Missing value for column: " + col.name);
+        record.emplace(col.name, parseValue(col, *text));
+    }
+    return record;
+}
+
+inline std::vector<Column> parseColumnDefinitions(std::span<const std::string_view> args) {
+    std::vector<Column> columns;
+    for (auto arg : args) {
+        auto pos = arg.find(':');
+        if (pos == std::string_view::npos) continue;
+        std::string_view name = arg.substr(0, pos);
+        std::string_view type = arg.substr(pos + 1);
+        DataType dt;
+        if      (type == "int")    dt = DataType::Integer;
+        else if (type == "float")  dt = DataType::Float;
+        else if (type == "string") dt = DataType::String;
+        else throw std::runtime_error("Invalid type: " + std::string(type));
+        columns.push_back({std::string(name), dt});
+    }
+    return columns;
+}
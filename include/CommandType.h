@@ -11,6 +11,12 @@ enum class CommandType {
     Insert,
     Select,
     SelectWhere,
+    Delete,
+    Update,
+    Checkpoint,
+    CheckpointStatus,
+    Bloom,
+    Zones,
     Exit,
     Help,
     Invalid
@@ -24,6 +30,12 @@ inline std::string to_string(CommandType type) {
         case CommandType::Insert:       return "insert";
         case CommandType::Select:       return "select";
         case CommandType::SelectWhere:  return "select_where";
+        case CommandType::Delete:       return "delete";
+        case CommandType::Update:       return "update";
+        case CommandType::Checkpoint:   return "checkpoint";
+        case CommandType::CheckpointStatus: return "checkpoint_status";
+        case CommandType::Bloom:        return "bloom";
+        case CommandType::Zones:        return "zones";
         case CommandType::Exit:         return "exit";
         case CommandType::Help:         return "help";
         default:                        return "invalid";
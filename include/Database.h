@@ -4,18 +4,109 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
 #include "Table.h"
+#include "ThreadPool.h"
 #include <filesystem>
 
+// Progress and timing of the most recent (or running) checkpoint.
+struct CheckpointStats {
+    bool running = false;
+    std::uint64_t rowsWritten = 0;
+    std::uint64_t rowsTotal = 0;                // upper bound when LSM tables hold unmerged overwrites
+    std::uint64_t bytesWritten = 0;
+    std::chrono::microseconds captureTime{0};   // time writers were held off while snapshotting
+    std::chrono::milliseconds duration{0};      // capture + write + rename
+    std::uint64_t completed = 0;
+    std::string lastError;                      // empty if the last checkpoint succeeded
+};
+
 class Database {
 public:
+    // On-disk format version written by save/checkpoint; load accepts 1..kFileVersion.
+    // v2: per-table Bloom filter config and table-level filters ahead of the rows.
+    // v3: per-table storage engine byte after the columns.
+    // v4: table directory (schema, body offset, length, row count) ahead of the table bodies.
+    // v5: per-table row-block index after the rows, so large tables decode in parallel.
+    // v6: declared primary key columns after the engine byte.
+    // v7: per-segment zone maps after the row-block index, located from the directory.
+    static constexpr std::uint8_t kFileVersion = 7;
+
     void createTable(const TableSchema& schema);
-    Table* getTable(const std::string& name);
+    // Throws if there is no such table. A table from a v4 file is decoded on its first lookup.
+    Table* getTable(std::string_view name);
+    bool hasTable(std::string_view name) const;
+    // Tables listed in the loaded file's directory that have not been decoded yet.
+    std::size_t pendingTableCount() const;
+    // Decodes every pending table now, tables and row blocks in parallel across the load pool.
+    void loadAllTables();
+    // Writes '<path>.tmp' and renames it over 'path', so saving back to the loaded file is safe.
+    // Returns false (and leaves 'path' untouched) if a table fails to decode or the write fails.
     bool saveToFile(const std::filesystem::path& path) const;
+    // Reads only the header and table directory of v4 files; older files are loaded in full.
     static std::unique_ptr<Database> loadFromFile(const std::filesystem::path& path);
 
+    // Captures a consistent snapshot of every table and writes it to 'path' on a background
+    // thread (via '<path>.tmp', fsynced, and an atomic rename). Returns false if a checkpoint is
+    // already running; rethrows (with the error in checkpointStats) if a table fails to snapshot.
+    bool checkpoint(const std::filesystem::path& path);
+    // Blocks until the running checkpoint (if any) has finished.
+    void waitForCheckpoint();
+    [[nodiscard]] CheckpointStats checkpointStats() const;
+
+    // Workers for parallel loads, index builds and sorts (Table::orderBy), started on first use.
+    ThreadPool& loadPool() const;
+
 private:
-    std::unordered_map<std::string, std::unique_ptr<Table>> tables;
+    // Rows per independently decodable block in a v5 table body.
+    static constexpr std::size_t kLoadBlockRows = 64 * Table::kSegmentRows;
+
+    // Where a not-yet-loaded table lives in sourcePath.
+    struct PendingTable {
+        TableSchema schema;
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::uint64_t rows;
+        std::uint64_t blocksOffset = 0;     // row-block index (v5); 0 = rows decode as one block
+        std::uint64_t zonesOffset = 0;      // zone maps (v7); 0 = computed while loading
+    };
+
+    std::unique_ptr<Table> decodeTable(const std::string& name, const PendingTable& entry) const;
+    Table* materialize(std::string_view name) const;
+    void materializeAll() const;
+    std::vector<TableSnapshot> captureSnapshots() const;
+    // Serializes snapshots in the MARI file format; 'progress' (optional) is updated per segment of rows.
+    static void writeSnapshots(std::ostream& os, const std::vector<TableSnapshot>& snapshots, CheckpointStats* progress,
+                               std::mutex* progressMutex);
+    // writeSnapshots into '<path>.tmp', syncs it to disk, then renames it over 'path'. Throws on failure.
+    static void writeFileAtomically(const std::filesystem::path& path, const std::vector<TableSnapshot>& snapshots,
+                                    CheckpointStats* progress, std::mutex* progressMutex);
+
+    // Transparent hash so getTable(string_view) looks up without building a std::string.
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    // Both maps are mutable: tables move from pending to loaded on first use, including from
+    // const paths that serialize the whole database.
+    mutable std::unordered_map<std::string, std::unique_ptr<Table>, NameHash, std::equal_to<>> tables;
+    mutable std::unordered_map<std::string, PendingTable, NameHash, std::equal_to<>> pendingTables;
+    mutable std::shared_mutex tablesMutex;
+    mutable std::mutex loadMutex;
+    std::filesystem::path sourcePath;
+    mutable std::once_flag loadPoolOnce;
+    mutable std::unique_ptr<ThreadPool> loadPoolPtr;
+
+    mutable std::mutex checkpointMutex;
+    CheckpointStats lastCheckpoint;
+    // Declared last so a running checkpoint is joined before the stats it updates are destroyed.
+    std::jthread checkpointer;
 };
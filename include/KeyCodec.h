@@ -0,0 +1,47 @@
+// Memcomparable encoding of composite primary keys. Comparing two encodings byte by byte
+// (memcmp, std::string operator<) orders them like the key columns, column by column, so a
+// composite key is indexed as a single std::string in the B+tree:
+//   int    -> 4 bytes big-endian, sign bit flipped
+//   float  -> 4 bytes big-endian IEEE image; sign bit flipped for positives, every bit for negatives
+//   string -> the bytes with 0x00 escaped as 0x00 0xFF, then the terminator 0x00 0x01
+// The terminator sorts below every escaped byte, so "ab" < "ab\0" < "abc" survives concatenation.
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Table.h"
+
+inline void appendKeyBytes(std::string& out, std::uint32_t bits) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>(bits >> shift));
+}
+
+inline void appendKeyPart(std::string& out, const Value& value) {
+    if (const int* i = std::get_if<int>(&value)) {
+        appendKeyBytes(out, static_cast<std::uint32_t>(*i) ^ 0x80000000u);
+    } else if (const float* f = std::get_if<float>(&value)) {
+        const float normalized = *f == 0.0f ? 0.0f : *f;     // -0.0f == +0.0f, so encode them alike
+        std::uint32_t bits;
+        std::memcpy(&bits, &normalized, sizeof bits);
+        appendKeyBytes(out, bits & 0x80000000u ? ~bits : bits ^ 0x80000000u);
+    } else {
+        for (char c : std::get<std::string>(value)) {
+            out.push_back(c);
+            if (c == '\0') out.push_back('\xff');
+        }
+        out.append("\0\1", 2);
+    }
+}
+
+inline std::string encodeKey(const std::vector<Value>& values) {
+    std::string out;
+    for (const auto& value : values) appendKeyPart(out, value);
+    return out;
+}
+
+inline std::string encodeKey(const Record& record, const std::vector<std::string>& columns) {
+    std::string out;
+    for (const auto& column : columns) appendKeyPart(out, record.at(column));
+    return out;
+}
@@ -0,0 +1,138 @@
+// Write-optimized storage engine for append-heavy tables (create_table ... engine=lsm).
+//
+// Writes are appended to an in-memory memtable and never search or touch disk on the caller's
+// thread; a memtable is sorted when it is frozen (or earlier, when a read needs its order). A
+// full memtable is frozen and a background thread writes it out as an immutable run file; runs
+// are merged size-tiered: once a level holds runsPerLevel runs they are merged into one run on
+// the next level. Reads merge memtables and runs, newest first, so the latest write (or delete)
+// of a key wins.
+//
+// If a flush or merge fails (e.g. the disk is full), its inputs stay in memory and it is
+// retried; the error is reported in stats(), and by put/remove once the flush queue is full.
+//
+// Run files are the engine's working storage and are removed with the tree; the database
+// file stays self-contained (tables are serialized from a snapshot, as for heap tables). So
+// the engine speeds up ingest, not persistence: saving or checkpointing an LSM table still
+// writes every live row, and there is no write-ahead log or run manifest to recover from.
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Table.h"
+
+struct LsmOptions {
+    std::filesystem::path directory;            // run files; empty = fresh directory under the temp path
+    std::size_t memtableEntries = 64 * 1024;    // freeze the memtable at this many entries (overwrites included)
+    std::size_t memtableBytes = 16 << 20;       // ... or once its encoded entries reach this size
+    std::size_t maxImmutableMemtables = 4;      // writers wait when this many are queued for flush
+    std::size_t runsPerLevel = 4;               // tiered compaction fan-in
+    std::size_t bloomBitsPerKey = 10;           // per-run key filter
+};
+
+struct LsmStats {
+    std::size_t memtableEntries = 0;
+    std::size_t immutableMemtables = 0;
+    std::size_t runs = 0;
+    std::size_t levels = 0;
+    std::uint64_t bytesOnDisk = 0;
+    std::uint64_t flushes = 0;
+    std::uint64_t compactions = 0;
+    std::uint64_t bloomProbes = 0;      // point reads that reached a run's key filter
+    std::uint64_t bloomNegatives = 0;   // ... and were turned away by it
+    std::uint64_t backgroundFailures = 0;   // flushes and merges that failed (and were retried)
+    std::string backgroundError;            // why the last one failed; empty once one succeeds
+};
+
+struct LsmMemtable;
+class LsmRun;
+
+// Callback for ordered scans; return false to stop early.
+using LsmVisitor = std::function<bool(const Record&)>;
+
+// Point-in-time view for checkpoints: frozen memtables plus the runs at capture time.
+class LsmView {
+public:
+    void scan(const LsmVisitor& fn) const;
+    // Entries across sources; an upper bound on live rows (overwrites/deletes not yet merged away).
+    [[nodiscard]] std::size_t entryCount() const;
+private:
+    friend class LsmTree;
+    std::vector<Column> columns;
+    std::vector<std::shared_ptr<const LsmMemtable>> memtables;  // newest first
+    std::vector<std::shared_ptr<const LsmRun>> runs;            // newest first
+};
+
+class LsmTree {
+public:
+    // Pause before a failed flush or merge is retried.
+    static constexpr std::chrono::milliseconds kRetryDelay{500};
+
+    LsmTree(std::vector<Column> columns, std::string keyColumn, LsmOptions options = {});
+    ~LsmTree();
+
+    LsmTree(const LsmTree&) = delete;
+    LsmTree& operator=(const LsmTree&) = delete;
+
+    // Upsert: a later put of the same key replaces the earlier record. Blocks only for backpressure;
+    // throws instead if the flushes it would wait for are failing.
+    void put(const Record& record);
+    // Writes a tombstone for key.
+    void remove(const Value& key);
+    [[nodiscard]] std::optional<Record> get(const Value& key) const;
+    // Live records with lower <= key < upper, in key order.
+    void scan(const std::optional<Value>& lower, const std::optional<Value>& upper, const LsmVisitor& fn) const;
+    [[nodiscard]] std::shared_ptr<const LsmView> view();
+    // Flushes all memtables and merges every run into one, dropping tombstones (synchronous).
+    // Throws if a flush or the merge fails; the runs it would have merged stay in place.
+    void compactAll();
+    [[nodiscard]] LsmStats stats() const;
+    [[nodiscard]] const std::string& keyColumn() const { return key; }
+
+private:
+    std::vector<Column> columns;
+    std::string key;
+    DataType keyType;
+    LsmOptions options;
+    bool ownsDirectory = false;
+
+    mutable std::shared_mutex treeMutex;
+    std::condition_variable_any workCv;
+    std::shared_ptr<LsmMemtable> active;
+    std::deque<std::shared_ptr<LsmMemtable>> immutables;       // front = oldest, flushed first
+    std::vector<std::vector<std::shared_ptr<LsmRun>>> levels;  // within a level, back = newest
+    std::uint64_t nextRunId = 0;
+    bool stopping = false;
+    bool majorRequested = false;
+    std::uint64_t backgroundFailures = 0;
+    std::string backgroundError;     // last failed flush or merge; cleared by the next success
+
+    std::atomic<std::uint64_t> flushes{0};
+    std::atomic<std::uint64_t> compactions{0};
+    mutable std::atomic<std::uint64_t> bloomProbes{0};
+    mutable std::atomic<std::uint64_t> bloomNegatives{0};
+
+    // Declared last so it stops before the state above is destroyed.
+    std::jthread worker;
+
+    // Helpers below expect treeMutex to be held by the caller (except on the worker's unlocked sections).
+    void write(const Value& key, const Record* record);     // record == nullptr: tombstone
+    // Shared lock with the active memtable's unsorted tail short enough to read (see LsmMemtable).
+    std::shared_lock<std::shared_mutex> lockForRead() const;
+    void freezeActiveLocked();
+    int levelToCompactLocked() const;
+    void collectSourcesLocked(std::vector<const LsmMemtable*>& memtables, std::vector<const LsmRun*>& runs) const;
+    void backgroundLoop(std::unique_lock<std::shared_mutex>& lock);
+    std::shared_ptr<LsmRun> writeRun(const std::vector<const LsmMemtable*>& memtables,
+                                  const std::vector<const LsmRun*>& runs, bool dropTombstones);
+};
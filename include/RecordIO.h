@@ -0,0 +1,95 @@
+// Row encoding shared by the database file and LSM run files: each column in schema order,
+// ints as 4 bytes, floats as their 4-byte IEEE image, strings length-prefixed (BinaryIO.h).
+
+#pragma once
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BinaryIO.h"
+#include "Table.h"
+
+inline void write_value(std::ostream& os, DataType type, const Value& value) {
+    if (type == DataType::Integer) {
+        write_uint32(os, static_cast<uint32_t>(std::get<int>(value)));
+    } else if (type == DataType::Float) {
+        float f = std::get<float>(value);
+        os.write(reinterpret_cast<char*>(&f), sizeof(float));
+    } else {
+        write_string(os, std::get<std::string>(value));
+    }
+}
+
+inline Value read_value(std::istream& is, DataType type) {
+    if (type == DataType::Integer) return static_cast<int>(read_uint32(is));
+    if (type == DataType::Float) {
+        float f;
+        is.read(reinterpret_cast<char*>(&f), sizeof(float));
+        return f;
+    }
+    return read_string(is);
+}
+
+inline void write_record(std::ostream& os, const std::vector<Column>& columns, const Record& record) {
+    for (const auto& col : columns)
+        write_value(os, col.type, record.at(col.name));
+}
+
+inline Record read_record(std::istream& is, const std::vector<Column>& columns) {
+    Record rec;
+    rec.reserve(columns.size());
+    for (const auto& col : columns)
+        rec.emplace(col.name, read_value(is, col.type));
+    return rec;
+}
+
+// The same encoding into and out of in-memory buffers (LSM memtables). parse_* advance 'in'.
+inline void append_value(std::string& out, DataType type, const Value& value) {
+    if (type == DataType::Integer) {
+        auto v = static_cast<uint32_t>(std::get<int>(value));
+        out.append(reinterpret_cast<const char*>(&v), sizeof v);
+    } else if (type == DataType::Float) {
+        float f = std::get<float>(value);
+        out.append(reinterpret_cast<const char*>(&f), sizeof f);
+    } else {
+        const auto& str = std::get<std::string>(value);
+        auto len = static_cast<uint16_t>(str.size());
+        out.append(reinterpret_cast<const char*>(&len), sizeof len);
+        out.append(str.data(), len);
+    }
+}
+
+inline Value parse_value(std::string_view& in, DataType type) {
+    if (type == DataType::Integer) {
+        uint32_t v;
+        std::memcpy(&v, in.data(), sizeof v);
+        in.remove_prefix(sizeof v);
+        return static_cast<int>(v);
+    }
+    if (type == DataType::Float) {
+        float f;
+        std::memcpy(&f, in.data(), sizeof f);
+        in.remove_prefix(sizeof f);
+        return f;
+    }
+    uint16_t len;
+    std::memcpy(&len, in.data(), sizeof len);
+    std::string str(in.substr(sizeof len, len));
+    in.remove_prefix(sizeof len + len);
+    return str;
+}
+
+inline void append_record(std::string& out, const std::vector<Column>& columns, const Record& record) {
+    for (const auto& col : columns)
+        append_value(out, col.type, record.at(col.name));
+}
+
+inline Record parse_record(std::string_view in, const std::vector<Column>& columns) {
+    Record rec;
+    rec.reserve(columns.size());
+    for (const auto& col : columns)
+        rec.emplace(col.name, parse_value(in, col.type));
+    return rec;
+}
@@ -9,6 +9,10 @@
 
 enum class DataType { Integer, String, Float };
 
+// Storage engine behind a table: BTree = row heap + B+tree index (default),
+// Lsm = log-structured merge tree keyed on the first column (see LsmTree.h).
+enum class TableEngine { BTree, Lsm };
+
 struct Column {
     std::string name;
     DataType type;
@@ -17,13 +21,21 @@ struct Column {
 
 class TableSchema {
 public:
-    TableSchema(std::string tableName, std::vector<Column> columns)
-        : tableName(std::move(tableName)), columns(std::move(columns)) {}
+    TableSchema(std::string tableName, std::vector<Column> columns, TableEngine engine = TableEngine::BTree,
+                std::vector<std::string> primaryKey = {})
+        : tableName(std::move(tableName)), columns(std::move(columns)), tableEngine(engine),
+          keyColumns(std::move(primaryKey)) {}
 
     [[nodiscard]] const std::string& name() const { return tableName; }
     [[nodiscard]] const std::vector<Column>& getColumns() const { return columns; }
+    [[nodiscard]] TableEngine engine() const { return tableEngine; }
+    // Declared primary key columns, in key order. Empty: the first column is the key when it is
+    // an int or string, and the table is unkeyed otherwise.
+    [[nodiscard]] const std::vector<std::string>& primaryKey() const { return keyColumns; }
 
 private:
     std::string tableName;
     std::vector<Column> columns;
+    TableEngine tableEngine;
+    std::vector<std::string> keyColumns;
 };
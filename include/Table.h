@@ -7,44 +7,371 @@
 #include <vector>
 #include <unordered_map>
 #include <variant>
+#include <optional>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
 #include "Schema.h"
 #include "BPlusTree.h"
+#include "BloomFilter.h"
 
 using Value = std::variant<int, float, std::string>;
 using Record = std::unordered_map<std::string, Value>;
 
+class LsmTree;
+class LsmView;
+class ThreadPool;
+
+// Platform-stable hash of a Value for Bloom filters (equal values hash equal).
+std::uint64_t bloomHash(const Value& value);
+
+// Bounds on one column for Table::scanRange; either side may be open. Equality is lower == upper.
+struct ValueRange {
+    std::optional<Value> lower;
+    std::optional<Value> upper;
+    bool lowerInclusive = true;
+    bool upperInclusive = true;
+
+    // NaN floats fall outside every bounded range.
+    [[nodiscard]] bool contains(const Value& value) const;
+};
+
+// Zone map: the range of one column over a segment's rows, widened as rows are inserted or updated.
+// Deletes never shrink it; compaction recomputes it. Columns are not nullable, so there is no null count.
+struct ZoneMap {
+    bool empty = true;                  // no value added yet (NaN floats are never added)
+    Value min;
+    Value max;
+    std::uint64_t distinctSketch = 0;   // one bit per hash bucket of the values (linear counting)
+
+    void add(const Value& value);
+    // False only if no value in [min, max] can satisfy 'range'.
+    [[nodiscard]] bool mayOverlap(const ValueRange& range) const;
+    // Estimated distinct values; saturates around 266 once every bucket is set.
+    [[nodiscard]] double distinctEstimate() const;
+};
+
+// Segments read by zone-map-filtered scans vs. segments their zone map ruled out. Segments a Bloom
+// filter rules out count as neither.
+struct ZoneMapStats {
+    std::uint64_t blocksScanned = 0;
+    std::uint64_t blocksSkipped = 0;
+};
+
+// Fixed-size slice of the row heap. Segments are shared between the live table and
+// any snapshots; the table clones a segment before writing to it if it is shared.
+struct RowSegment {
+    std::vector<Record> rows;
+    std::vector<bool> tombstones;   // tombstones[i] == true: rows[i] is deleted
+    std::uint64_t epoch = 0;        // Table snapshot epoch this copy was made writable in
+    std::vector<BlockedBloomFilter> blooms;     // one per Table bloom column, over this segment's rows
+    std::vector<ZoneMap> zones;                 // one per schema column, over this segment's rows
+};
+
+// Counters for Bloom filter probes on a table. A "negative" skipped the index or scan outright;
+// a false positive passed the filter but matched no row.
+struct BloomStats {
+    std::uint64_t probes = 0;
+    std::uint64_t negatives = 0;
+    std::uint64_t falsePositives = 0;
+
+    [[nodiscard]] double falsePositiveRate() const {
+        const auto absent = negatives + falsePositives;
+        return absent ? static_cast<double>(falsePositives) / static_cast<double>(absent) : 0.0;
+    }
+};
+
+enum class SortOrder { Ascending, Descending };
+
+// How Table::orderBy produced its rows.
+enum class OrderByPlan {
+    IndexScan,      // streamed along the key index (or LSM key order); no sort, stops after 'limit' rows
+    TopN,           // bounded heap of 'limit' entries per worker over one pass of the heap
+    MemorySort,     // (value, row id) pairs sorted in parallel in memory
+    ExternalSort    // sorted runs within the memory budget spilled to temp files, then k-way merged
+};
+
+inline std::string to_string(OrderByPlan plan) {
+    switch (plan) {
+        case OrderByPlan::IndexScan:    return "index scan";
+        case OrderByPlan::TopN:         return "top-N heap";
+        case OrderByPlan::MemorySort:   return "in-memory sort";
+        case OrderByPlan::ExternalSort: return "external merge sort";
+    }
+    return "unknown";
+}
+
+// Immutable point-in-time view of a table. Capturing one costs a copy of the segment
+// pointer list; the rows themselves are shared copy-on-write with the live table.
+class TableSnapshot {
+public:
+    [[nodiscard]] const TableSchema& schema() const { return tableSchema; }
+    [[nodiscard]] std::size_t liveRowCount() const { return liveRows; }
+    [[nodiscard]] const std::vector<std::string>& bloomColumns() const { return bloomColumnNames; }
+    [[nodiscard]] std::size_t bloomBitsPerKey() const { return bloomBits; }
+
+    template<typename Fn>
+    void forEachRecord(Fn&& fn) const {
+        if (lsmView) {
+            forEachLsmRecord([&](const Record& record) { fn(record); return true; });
+            return;
+        }
+        for (const auto& segment : segments) {
+            for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+                if (!segment->tombstones[i]) fn(segment->rows[i]);
+            }
+        }
+    }
+
+private:
+    friend class Table;
+    TableSnapshot(TableSchema schema, std::vector<std::shared_ptr<const RowSegment>> segments, std::size_t liveRows,
+                  std::vector<std::string> bloomColumns, std::size_t bloomBitsPerKey,
+                  std::shared_ptr<const LsmView> lsmView = nullptr)
+        : tableSchema(std::move(schema)), segments(std::move(segments)), liveRows(liveRows),
+          bloomColumnNames(std::move(bloomColumns)), bloomBits(bloomBitsPerKey), lsmView(std::move(lsmView)) {}
+
+    void forEachLsmRecord(const std::function<bool(const Record&)>& fn) const;
+
+    TableSchema tableSchema;
+    std::vector<std::shared_ptr<const RowSegment>> segments;
+    std::size_t liveRows;
+    std::vector<std::string> bloomColumnNames;
+    std::size_t bloomBits;
+    std::shared_ptr<const LsmView> lsmView;     // LSM tables: rows come from here, liveRows is an upper bound
+};
+
 // Table now supports indexing (production-grade):
-// - Supports optional BPlusTree index on first column if int or string.
+// - Indexes the primary key: the schema's declared key columns, else the first column if int or string.
+// - A composite key is indexed by its memcomparable encoding (KeyCodec.h) in a string B+tree.
 // - Transparent, diagnostics-friendly, type safe.
-// - For additional key types/compound keys, extend key logic and index member.
+//
+// Deletes are tombstones in the row heap, so erase is O(log N) through the index.
+// Once the tombstone ratio passes compactionThreshold(), a background thread
+// rewrites the heap without dead rows and rebuilds the row-id index from a snapshot,
+// then takes the table lock only to apply the writes made meanwhile and swap it in.
+// All public members are safe to call concurrently with that compaction.
+//
+// The heap is a list of kSegmentRows-sized RowSegments so snapshot() is cheap and
+// a checkpoint can serialize it while inserts and selects keep running.
+//
+// Bloom filters (the key column by default, plus any added with addBloomFilter) are kept
+// for the whole table and for each segment. Lookups consult the table filter before the
+// index or a scan, and scans skip segments whose filter rules the value out.
+//
+// orderBy streams rows sorted on a column: along the key index when the column leads the key,
+// through a bounded heap per worker for small limits, else as a parallel sort of (value, row id)
+// pairs, spilled to temp-file runs and merged when they outgrow sortMemoryBudget().
+//
+// Every segment also keeps a zone map (min/max) per column, so equality and range scans skip
+// segments whose values cannot match; on clustered data (timestamps, increasing ids) that is most.
+//
+// With TableEngine::Lsm the rows live in an LsmTree keyed on the first column instead of
+// the heap and B+tree: insert is an upsert, iteration is in key order, and the per-run key
+// filters replace the table Bloom filters.
 
 class Table {
 public:
+    // Rows per heap segment; row id = segment * kSegmentRows + offset.
+    static constexpr std::size_t kSegmentRows = 1024;
+
     explicit Table(TableSchema  schema);
+    ~Table();
 
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    // Throws on schema mismatch or on a duplicate key when the table is indexed.
+    // LSM tables replace the record with the same key instead, without taking the table lock,
+    // and throw if the tree's flushes are failing and its flush queue is full.
     void insert(const Record& record);
-    [[nodiscard]] const std::vector<Record>& getRecords() const;
+    void insert(Record&& record);
+    // Loads rows into an empty table in one pass (used by Database load): segments and their
+    // filters are filled per segment on 'pool', and the key index is built from key/row-id pairs
+    // sorted in parallel instead of N inserts. Throws on schema mismatch, a duplicate key (the
+    // table is then left empty) or if the table already has rows. 'zones' (persisted zone maps,
+    // one list of per-column maps for each segment of rows) are installed as given instead of computed.
+    void bulkLoad(std::vector<Record> rows, ThreadPool* pool = nullptr, std::vector<std::vector<ZoneMap>> zones = {});
+    // Snapshot copy of all live (non-deleted) records, in insertion order.
+    [[nodiscard]] std::vector<Record> getRecords() const;
     [[nodiscard]] const TableSchema& schema() const { return tableSchema; }
 
-    // Find using key for indexed column (first column, currently only int/string supported).
-    // Returns pointer to record if found, nullptr otherwise.
-    const Record* findByKey(const Value& key) const;
+    // Visits every live record in insertion order (key order for LSM tables) under a shared lock.
+    // If fn returns bool, false stops the scan.
+    template<typename Fn>
+    void forEachRecord(Fn&& fn) const {
+        const auto visit = [&](const Record& record) {
+            if constexpr (std::is_same_v<std::invoke_result_t<Fn&, const Record&>, bool>) return fn(record);
+            else { fn(record); return true; }
+        };
+        std::shared_lock lock(tableMutex);
+        if (lsm) {
+            forEachLsmRecord(visit);
+            return;
+        }
+        for (const auto& segment : segments) {
+            for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+                if (!segment->tombstones[i] && !visit(segment->rows[i])) return;
+            }
+        }
+    }
+
+    // Point-in-time view of the live rows (see TableSnapshot).
+    [[nodiscard]] TableSnapshot snapshot() const;
+    // Shared lock over the table; hold one per table to capture a consistent multi-table cut,
+    // then call snapshot(lock) for each.
+    [[nodiscard]] std::shared_lock<std::shared_mutex> lockShared() const;
+    [[nodiscard]] TableSnapshot snapshot(const std::shared_lock<std::shared_mutex>& held) const;
+
+    // Find using key for indexed column (single-column keys). Returns a copy of the record if found.
+    // An unkeyed table scans its first column; a composite key throws (use the overload below).
+    std::optional<Record> findByKey(const Value& key) const;
+    // Lookup by the full key: one value per key column, in key order. Throws on a count or type mismatch.
+    std::optional<Record> findByKey(const std::vector<Value>& key) const;
+    // First live record with column == value; uses the index when column is the key column.
+    std::optional<Record> findFirst(const std::string& column, const Value& value) const;
 
-    // Returns true if table is indexed.
-    bool isIndexed() const { return indexActive; }
-    // Index diagnostics
+    // Visits the live records with column in 'range' under a shared lock, in insertion order (key order
+    // for LSM tables); fn returns false to stop. Segments whose zone map misses the range are skipped.
+    // Throws if the column is unknown or a bound has the wrong type. Returns the number of records visited.
+    std::size_t scanRange(const std::string& column, const ValueRange& range,
+                          const std::function<bool(const Record&)>& fn) const;
+
+    // Visits up to 'limit' live records ordered by 'column' under a shared lock; fn returns false to stop.
+    // Ties come out in insertion order (key order for LSM tables and index scans on a composite key's
+    // first column). Throws if the column is unknown. Returns the strategy that was used.
+    static constexpr std::size_t kNoLimit = std::numeric_limits<std::size_t>::max();
+    OrderByPlan orderBy(const std::string& column, SortOrder order, std::size_t limit,
+                        const std::function<bool(const Record&)>& fn, ThreadPool* pool = nullptr) const;
+
+    // Deletes all live records with column == value. Returns number of rows deleted.
+    std::size_t erase(const std::string& column, const Value& value);
+    // Applies 'changes' (subset of columns) to all live records with column == value.
+    // Returns number of rows updated. Throws on type mismatch or key collision.
+    std::size_t update(const std::string& column, const Value& value, const Record& changes);
+
+    // Rewrites the heap without tombstones and rebuilds the index (synchronous).
+    void compact();
+
+    // Returns true if table is indexed (an LSM table is always keyed on one column).
+    bool isIndexed() const { return indexActive || lsm; }
+    [[nodiscard]] TableEngine engine() const { return tableSchema.engine(); }
+    // Index diagnostics: the key column of a single-column key (empty for composite keys).
     std::string indexColumn() const { return indexedColumnName; }
+    // Primary key columns in key order; empty if the table is unkeyed.
+    [[nodiscard]] const std::vector<std::string>& keyColumns() const { return keyColumnNames; }
+    // O(N) merge scan for LSM tables.
+    std::size_t liveRowCount() const;
+    std::size_t tombstoneCount() const;
+    // Adds a Bloom filter on 'column' (no-op if it already has one). Throws if the column is unknown,
+    // or for LSM tables, whose runs carry their own key filters.
+    void addBloomFilter(const std::string& column);
+    // Resizes every filter for the new bits-per-key (rebuilt from the live rows).
+    void setBloomBitsPerKey(std::size_t bitsPerKey);
+    std::size_t bloomBitsPerKey() const;
+    std::vector<std::string> bloomFilterColumns() const;
+    // Installs a persisted table-level filter for an existing bloom column (used by load). Its bits
+    // must cover exactly the rows of the next bulkLoad, which then keeps them instead of re-adding keys.
+    void restoreBloomFilter(const std::string& column, BlockedBloomFilter filter);
+    BloomStats bloomStats() const;
+    // Zone map of 'column' for each heap segment (empty for LSM tables). Throws if the column is unknown.
+    std::vector<ZoneMap> zoneMaps(const std::string& column) const;
+    ZoneMapStats zoneMapStats() const;
+
+    // Fraction of dead rows in the heap that schedules a background compaction.
+    double compactionThreshold() const { return compactionRatio; }
+    void setCompactionThreshold(double ratio) { compactionRatio = ratio; }
+
+    // Bytes of sort entries orderBy keeps in memory before it spills sorted runs to disk.
+    std::size_t sortMemoryBudget() const { return sortBudget; }
+    void setSortMemoryBudget(std::size_t bytes) { sortBudget = bytes; }
 
 private:
     TableSchema tableSchema;
-    std::vector<Record> records;
+    std::vector<std::shared_ptr<RowSegment>> segments;
+    std::size_t rowCount = 0;       // heap slots, live and dead
+    std::size_t deadRows = 0;
+    // Bumped by every snapshot (under a shared lock, hence atomic); segments from an older epoch are frozen.
+    mutable std::atomic<std::uint64_t> snapshotEpoch{0};
 
-    // Optional index member(s). Only one active (for now).
-    std::unique_ptr<BPlusTree<int, Record>> intIndex;
-    std::unique_ptr<BPlusTree<std::string, Record>> stringIndex;
+    // Optional index member(s). Only one active (for now). Maps key -> row id in the heap.
+    std::unique_ptr<BPlusTree<int, std::size_t>> intIndex;
+    std::unique_ptr<BPlusTree<std::string, std::size_t>> stringIndex;
     bool indexActive = false;
+    bool compositeKey = false;      // stringIndex holds encodeKey() of the key columns
     std::string indexedColumnName;
+    std::vector<std::string> keyColumnNames;
 
-    // Checks the schema at construction and sets up suitable index if first col is int or string.
+    // Bloom filters: bloomColumns[i] is covered by tableBlooms[i] and by RowSegment::blooms[i].
+    static constexpr std::size_t kDefaultBloomBitsPerKey = 10;
+    std::size_t bloomBits = kDefaultBloomBitsPerKey;
+    std::vector<std::string> bloomColumns;
+    std::vector<BlockedBloomFilter> tableBlooms;
+    std::vector<bool> restoredBlooms;   // tableBlooms[i] came from restoreBloomFilter; cleared by bulkLoad/rebuilds
+    mutable std::atomic<std::uint64_t> bloomProbes{0};
+    mutable std::atomic<std::uint64_t> bloomNegatives{0};
+    mutable std::atomic<std::uint64_t> bloomFalsePositives{0};
+    mutable std::atomic<std::uint64_t> zoneBlocksScanned{0};
+    mutable std::atomic<std::uint64_t> zoneBlocksSkipped{0};
+
+    // Tables smaller than this never compact in the background; the dead rows are cheap to carry.
+    static constexpr std::size_t kMinCompactionRows = 64;
+    double compactionRatio = 0.3;
+    bool compactionScheduled = false;
+    // Bumped whenever the heap is replaced (row ids change), so a compaction built meanwhile is dropped.
+    std::uint64_t heapGeneration = 0;
+
+    static constexpr std::size_t kDefaultSortMemoryBudget = 64 << 20;
+    std::size_t sortBudget = kDefaultSortMemoryBudget;
+
+    // Set for TableEngine::Lsm; the heap, index and bloom members above are then unused.
+    std::unique_ptr<LsmTree> lsm;
+
+    mutable std::shared_mutex tableMutex;
+    // Declared last so it is joined before any state it touches is destroyed.
+    std::jthread compactor;
+
+    // Resolves the key columns at construction (throws on an invalid key) and creates the index.
     void setupIndex();
+    // Index key of a record: the key column's value, or the encoded composite key.
+    Value indexKey(const Record& record) const;
+    // Key column names for error messages ("a" or "a,b").
+    std::string keyLabel() const;
+    void validate(const Record& record) const;
+
+    // Helpers below expect tableMutex to be held by the caller.
+    std::optional<std::size_t> indexFind(const Value& key) const;
+    void indexInsert(const Value& key, std::size_t row);
+    void indexErase(const Value& key);
+    // Rebuilds the key index from the heap rows, which must hold no tombstones.
+    void rebuildIndex(ThreadPool* pool);
+    std::vector<std::size_t> matchingRows(const std::string& column, const Value& value) const;
+    int bloomIndex(const std::string& column) const;
+    void bloomAdd(RowSegment& segment, const Record& record);
+    void zoneAdd(RowSegment& segment, const Record& record) const;
+    // Position of 'column' in the schema, or -1.
+    int columnIndex(const std::string& column) const;
+    // Rebuilds the table filters (and, if asked, every segment's) from the live rows, sized for growth.
+    void rebuildBloomFilters(bool includeSegments);
+    const Record& rowAt(std::size_t row) const;
+    bool isDead(std::size_t row) const;
+    // Segment holding 'row', cloned first if a snapshot may still share it.
+    RowSegment& writableSegment(std::size_t row);
+    // Compaction in three steps: capture the segments (any lock), build the packed heap, index and
+    // filters from them (no lock), then carry over later writes and swap it in (unique lock).
+    struct CompactedHeap;
+    std::unique_ptr<CompactedHeap> captureCompaction() const;
+    void buildCompacted(CompactedHeap& heap) const;
+    void installCompacted(CompactedHeap& heap);
+    void compactLocked();
+    void maybeScheduleCompaction();
+    void forEachLsmRecord(const std::function<bool(const Record&)>& fn) const;
+    // Keys of the live LSM records with column == value.
+    std::vector<Value> lsmMatchingKeys(const std::string& column, const Value& value) const;
+    std::size_t updateLsm(const std::string& column, const Value& value, const Record& changes);
 };
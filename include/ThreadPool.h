@@ -0,0 +1,63 @@
+// Fixed pool of worker threads for data-parallel loading and index builds.
+//
+// parallelFor is the only entry point. The calling thread claims work items alongside the
+// workers, so a parallelFor issued from inside another one (tables in parallel, each decoding
+// its row blocks in parallel) always makes progress even when every worker is busy.
+
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // threads == 0: one worker per hardware thread, less the caller's.
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads that can work on one parallelFor: the workers plus the caller.
+    [[nodiscard]] std::size_t concurrency() const { return workers.size() + 1; }
+
+    // Runs fn(i) for every i in [0, count) and returns once all calls are done.
+    // Rethrows the first exception thrown by fn; items not yet started are then skipped.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+private:
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+    std::vector<std::jthread> workers;
+
+    void workerLoop();
+};
+
+// Sorts [first, last): chunks are sorted on the pool, then merged pairwise in parallel rounds.
+template<typename RandomIt, typename Compare>
+void parallelSort(ThreadPool* pool, RandomIt first, RandomIt last, Compare comp) {
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    constexpr std::size_t kMinChunk = 16 * 1024;
+    const std::size_t chunks = pool ? std::min(pool->concurrency(), n / kMinChunk) : 1;
+    if (chunks < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+    auto bound = [&](std::size_t c) { return first + static_cast<std::ptrdiff_t>(std::min(n, n * c / chunks)); };
+    pool->parallelFor(chunks, [&](std::size_t c) { std::sort(bound(c), bound(c + 1), comp); });
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+        pool->parallelFor((chunks + 2 * width - 1) / (2 * width), [&](std::size_t m) {
+            const std::size_t lo = 2 * width * m;
+            if (lo + width < chunks)
+                std::inplace_merge(bound(lo), bound(lo + width), bound(std::min(chunks, lo + 2 * width)), comp);
+        });
+    }
+}
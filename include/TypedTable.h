@@ -0,0 +1,271 @@
+// Compile-time typed table facade for embedding MarinaDB as a library.
+//
+//   using Users = TypedTable<Col<"id", int>, Col<"name", std::string>, Col<"score", float>>;
+//   Users users("users");
+//   users.insert(1, "Alice", 9.5f);
+//   if (const auto* row = users.find(1)) std::cout << row->get<"name">();
+//   users.forEach([](const Users::Row& r) { total += r.get<"score">(); });
+//   users.saveTo(db);                                 // runtime Table, persisted as usual
+//   auto again = Users::loadFrom(db, "users");
+//
+// Column names and types are template arguments, so get<"nmae">() or a float read as a string
+// fail to compile. Each Row is a packed struct: ints and floats sit in one byte block at
+// constexpr offsets, strings in a fixed array at constexpr slots; reads are a 4-byte load or a
+// reference, with no hashing and no variant dispatch. The first column is the key (B+tree
+// indexed and unique) when it is an int or a string, as for the runtime Table.
+//
+// Like the containers it wraps, a TypedTable is not synchronized; the runtime Table remains the
+// thread-safe, shared representation.
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "BPlusTree.h"
+#include "Database.h"
+#include "Schema.h"
+#include "Table.h"
+
+// String literal usable as a template argument: Col<"id", int>.
+template<std::size_t N>
+struct FixedString {
+    char chars[N]{};
+    constexpr FixedString(const char (&str)[N]) { std::copy_n(str, N, chars); }
+    [[nodiscard]] constexpr std::string_view view() const { return {chars, N - 1}; }
+};
+
+// One column of a TypedTable: a name and a C++ type (int, float or std::string).
+template<FixedString Name, typename T>
+struct Col {
+    static_assert(std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, std::string>,
+                  "TypedTable columns must be int, float or std::string");
+    using type = T;
+    static constexpr std::string_view name = Name.view();
+    static constexpr DataType dataType = std::is_same_v<T, int>   ? DataType::Integer
+                                       : std::is_same_v<T, float> ? DataType::Float
+                                                                  : DataType::String;
+};
+
+template<typename... Cols>
+class TypedTable {
+public:
+    static_assert(sizeof...(Cols) > 0, "TypedTable needs at least one column");
+
+    static constexpr std::size_t kColumns = sizeof...(Cols);
+    static constexpr std::array<std::string_view, kColumns> kNames{Cols::name...};
+    static constexpr std::array<DataType, kColumns> kTypes{Cols::dataType...};
+
+    template<std::size_t I>
+    using ColumnType = typename std::tuple_element_t<I, std::tuple<Cols...>>::type;
+
+    // Position of column Name in the schema; kColumns if there is none (get<> turns that into a compile error).
+    template<FixedString Name>
+    static constexpr std::size_t kIndexOf = [] {
+        for (std::size_t i = 0; i < kColumns; ++i) {
+            if (kNames[i] == Name.view()) return i;
+        }
+        return kColumns;
+    }();
+
+    // Row layout: byte offset into the fixed block for ints/floats, slot in the string array for strings.
+    static constexpr std::array<std::size_t, kColumns> kOffsets = [] {
+        std::array<std::size_t, kColumns> offsets{};
+        std::size_t fixed = 0, strings = 0;
+        for (std::size_t i = 0; i < kColumns; ++i)
+            offsets[i] = kTypes[i] == DataType::String ? strings++ : std::exchange(fixed, fixed + 4);
+        return offsets;
+    }();
+    static constexpr std::size_t kStringCount =
+        static_cast<std::size_t>(std::count(kTypes.begin(), kTypes.end(), DataType::String));
+    static constexpr std::size_t kFixedBytes = 4 * (kColumns - kStringCount);
+
+    static constexpr bool kIndexed = !std::is_same_v<ColumnType<0>, float>;
+    using Key = ColumnType<0>;
+
+    class Row {
+    public:
+        Row() = default;
+        explicit Row(const typename Cols::type&... values) {
+            assign(std::index_sequence_for<Cols...>{}, values...);
+        }
+
+        template<std::size_t I>
+        [[nodiscard]] decltype(auto) get() const {
+            static_assert(I < kColumns, "column index out of range");
+            if constexpr (std::is_same_v<ColumnType<I>, std::string>) {
+                return static_cast<const std::string&>(strings[kOffsets[I]]);
+            } else {
+                ColumnType<I> value;
+                std::memcpy(&value, fixed.data() + kOffsets[I], sizeof value);
+                return value;
+            }
+        }
+        template<FixedString Name>
+        [[nodiscard]] decltype(auto) get() const {
+            static_assert(kIndexOf<Name> < kColumns, "no such column in this TypedTable");
+            return get<kIndexOf<Name>>();
+        }
+
+        template<std::size_t I>
+        void set(ColumnType<I> value) {
+            static_assert(I < kColumns, "column index out of range");
+            if constexpr (std::is_same_v<ColumnType<I>, std::string>)
+                strings[kOffsets[I]] = std::move(value);
+            else
+                std::memcpy(fixed.data() + kOffsets[I], &value, sizeof value);
+        }
+        template<FixedString Name>
+        void set(ColumnType<kIndexOf<Name>> value) {
+            static_assert(kIndexOf<Name> < kColumns, "no such column in this TypedTable");
+            set<kIndexOf<Name>>(std::move(value));
+        }
+
+    private:
+        template<std::size_t... I>
+        void assign(std::index_sequence<I...>, const typename Cols::type&... values) {
+            (set<I>(values), ...);
+        }
+
+        alignas(4) std::array<unsigned char, kFixedBytes> fixed{};
+        std::array<std::string, kStringCount> strings;
+    };
+
+    explicit TypedTable(std::string name) : tableName(std::move(name)) {
+        if constexpr (kIndexed) index = std::make_unique<BPlusTree<Key, std::size_t>>();
+    }
+
+    TypedTable(TypedTable&&) noexcept = default;
+    TypedTable& operator=(TypedTable&&) noexcept = default;
+
+    [[nodiscard]] const std::string& name() const { return tableName; }
+    [[nodiscard]] std::size_t size() const { return rows.size(); }
+
+    // Runtime schema equivalent to the column list, for Database/Table interop.
+    [[nodiscard]] TableSchema schema() const {
+        std::vector<Column> columns;
+        columns.reserve(kColumns);
+        for (std::size_t i = 0; i < kColumns; ++i) columns.push_back({std::string(kNames[i]), kTypes[i]});
+        return TableSchema(tableName, std::move(columns));
+    }
+
+    // Throws on a duplicate key when the table is keyed.
+    void insert(Row row) {
+        if constexpr (kIndexed) {
+            const Key key = row.template get<0>();
+            if (index->find(key))
+                throw std::runtime_error("Duplicate key for column: " + std::string(kNames[0]));
+            index->insert(key, rows.size());
+        }
+        rows.push_back(std::move(row));
+    }
+    void insert(const typename Cols::type&... values) {
+        insert(Row(values...));
+    }
+
+    // Row with the given key, or nullptr. Valid until the next insert.
+    [[nodiscard]] const Row* find(const Key& key) const requires kIndexed {
+        auto row = index->find(key);
+        return row ? &rows[*row] : nullptr;
+    }
+
+    template<typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& row : rows) fn(row);
+    }
+
+    // -- RUNTIME INTEROP --
+
+    [[nodiscard]] static Record toRecord(const Row& row) {
+        Record record;
+        record.reserve(kColumns);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (record.emplace(std::string(kNames[I]), Value(row.template get<I>())), ...);
+        }(std::index_sequence_for<Cols...>{});
+        return record;
+    }
+
+    // Throws if the record lacks a column or holds the wrong type for it.
+    [[nodiscard]] static Row fromRecord(const Record& record) {
+        Row row;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (row.template set<I>(fieldOf<I>(record)), ...);
+        }(std::index_sequence_for<Cols...>{});
+        return row;
+    }
+
+    // Appends every row to 'table', whose schema must match column for column.
+    void exportTo(Table& table) const {
+        requireCompatible(table.schema());
+        for (const auto& row : rows) table.insert(toRecord(row));
+    }
+
+    [[nodiscard]] static TypedTable importFrom(const Table& table) {
+        requireCompatible(table.schema());
+        TypedTable typed(table.schema().name());
+        table.forEachRecord([&](const Record& record) { typed.insert(fromRecord(record)); });
+        return typed;
+    }
+
+    // Creates the runtime table in 'db' if needed and upserts the rows: a row whose key is already
+    // in the table replaces that record, so saving the same typed table twice is idempotent rather
+    // than failing on the first duplicate. Tables keyed on a float have no key to match on and are
+    // appended. Persist with Database::saveToFile.
+    void saveTo(Database& db) const {
+        if (!db.hasTable(tableName)) db.createTable(schema());
+        Table& table = *db.getTable(tableName);
+        if constexpr (!kIndexed) {
+            exportTo(table);
+        } else {
+            requireCompatible(table.schema());
+            const std::string keyName(kNames[0]);
+            for (const auto& row : rows) {
+                Record record = toRecord(row);
+                const Value key = record.at(keyName);
+                // Only the other columns change, so the key index is left alone.
+                Record changes = record;
+                changes.erase(keyName);
+                if (table.update(keyName, key, changes) == 0) table.insert(std::move(record));
+            }
+        }
+    }
+
+    [[nodiscard]] static TypedTable loadFrom(Database& db, std::string_view name) {
+        return importFrom(*db.getTable(name));
+    }
+
+private:
+    // Behind a pointer so the table stays movable (BPlusTree is not).
+    using Index = std::conditional_t<kIndexed, std::unique_ptr<BPlusTree<Key, std::size_t>>, std::monostate>;
+
+    std::string tableName;
+    std::vector<Row> rows;
+    Index index;
+
+    template<std::size_t I>
+    static ColumnType<I> fieldOf(const Record& record) {
+        const std::string name(kNames[I]);
+        auto it = record.find(name);
+        if (it == record.end()) throw std::runtime_error("Missing column: " + name);
+        if (!std::holds_alternative<ColumnType<I>>(it->second))
+            throw std::runtime_error("Type mismatch for column: " + name);
+        return std::get<ColumnType<I>>(it->second);
+    }
+
+    static void requireCompatible(const TableSchema& schema) {
+        const auto& columns = schema.getColumns();
+        bool same = columns.size() == kColumns;
+        for (std::size_t i = 0; same && i < kColumns; ++i)
+            same = columns[i].name == kNames[i] && columns[i].type == kTypes[i];
+        if (!same) throw std::runtime_error("Schema of table '" + schema.name() + "' does not match the typed table.");
+    }
+};
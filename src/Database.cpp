@@ -2,67 +2,456 @@
 // Created by Ilija Mandic on 4/18/2024.
 //
 #include "BinaryIO.h"
+#include "RecordIO.h"
 #include "Database.h"
+#include <optional>
 #include <stdexcept>
 #include <fstream>
 #include <iostream>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "Table.h"
+#include "ThreadPool.h"
+
+namespace {
+// Forces 'path' (a file, or on POSIX a directory) out of the OS cache onto the device. Throws on failure.
+void syncToDisk(const std::filesystem::path& path) {
+#ifdef _WIN32
+    const int fd = _wopen(path.c_str(), _O_RDWR | _O_BINARY);
+    const bool ok = fd >= 0 && _commit(fd) == 0;
+    if (fd >= 0) _close(fd);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    const bool ok = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+#endif
+    if (!ok) throw std::runtime_error("Failed to sync to disk: " + path.string());
+}
+
+void writeSchema(std::ostream& os, const TableSchema& schema) {
+    write_string(os, schema.name());
+    const auto& columns = schema.getColumns();
+    write_uint16(os, static_cast<uint16_t>(columns.size()));
+    for (const auto& col : columns) {
+        write_string(os, col.name);
+        write_uint8(os, static_cast<uint8_t>(col.type));
+    }
+    // Storage engine (v3)
+    write_uint8(os, static_cast<uint8_t>(schema.engine()));
+    // Declared primary key (v6)
+    write_uint8(os, static_cast<uint8_t>(schema.primaryKey().size()));
+    for (const auto& key : schema.primaryKey()) write_string(os, key);
+}
+
+TableSchema readSchema(std::istream& is, std::uint8_t version) {
+    std::string table_name = read_string(is);
+    uint16_t column_count = read_uint16(is);
+    std::vector<Column> columns;
+    for (uint16_t c = 0; c < column_count; ++c) {
+        std::string col_name = read_string(is);
+        DataType col_type = static_cast<DataType>(read_uint8(is));
+        columns.push_back({col_name, col_type});
+    }
+    TableEngine engine = version >= 3 ? static_cast<TableEngine>(read_uint8(is)) : TableEngine::BTree;
+    std::vector<std::string> primaryKey(version >= 6 ? read_uint8(is) : 0);
+    for (auto& key : primaryKey) key = read_string(is);
+    return TableSchema(table_name, columns, engine, std::move(primaryKey));
+}
+
+// Bloom filters (v2): config, then table-level filters over exactly the rows that follow.
+void writeBloomSection(std::ostream& os, const TableSnapshot& snap) {
+    const auto& bloomColumns = snap.bloomColumns();
+    write_uint8(os, static_cast<uint8_t>(snap.bloomBitsPerKey()));
+    write_uint16(os, static_cast<uint16_t>(bloomColumns.size()));
+    std::vector<BlockedBloomFilter> filters(bloomColumns.size(),
+        BlockedBloomFilter(std::max(Table::kSegmentRows, 2 * snap.liveRowCount()), snap.bloomBitsPerKey()));
+    if (!bloomColumns.empty()) {
+        snap.forEachRecord([&](const Record& record) {
+            for (std::size_t b = 0; b < bloomColumns.size(); ++b)
+                filters[b].add(bloomHash(record.at(bloomColumns[b])));
+        });
+    }
+    for (std::size_t b = 0; b < bloomColumns.size(); ++b) {
+        write_string(os, bloomColumns[b]);
+        write_uint32(os, static_cast<uint32_t>(filters[b].capacity()));
+        write_uint8(os, filters[b].probeCount());
+        write_uint32(os, static_cast<uint32_t>(filters[b].bits().size()));
+        for (auto word : filters[b].bits()) write_uint64(os, word);
+    }
+}
+
+void readBloomSection(std::istream& is, Table& table) {
+    // Configure the filters before rows arrive; the persisted table filters are already sized for them.
+    table.setBloomBitsPerKey(read_uint8(is));
+    uint16_t bloom_count = read_uint16(is);
+    for (uint16_t b = 0; b < bloom_count; ++b) {
+        std::string bloom_column = read_string(is);
+        uint32_t capacity = read_uint32(is);
+        uint8_t probes = read_uint8(is);
+        std::vector<std::uint64_t> words(read_uint32(is));
+        for (auto& word : words) word = read_uint64(is);
+        table.addBloomFilter(bloom_column);
+        table.restoreBloomFilter(bloom_column, BlockedBloomFilter(capacity, probes, std::move(words)));
+    }
+}
+
+// Zone maps (v7): for each Table::kSegmentRows rows written, per column a flag byte, then min and
+// max if the column had a value, and the distinct sketch.
+void writeZoneSection(std::ostream& os, const std::vector<Column>& columns, const std::vector<std::vector<ZoneMap>>& zones) {
+    write_uint32(os, static_cast<uint32_t>(Table::kSegmentRows));
+    write_uint32(os, static_cast<uint32_t>(zones.size()));
+    for (const auto& segment : zones) {
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+            const ZoneMap& zone = segment[c];
+            write_uint8(os, zone.empty ? 0 : 1);
+            if (!zone.empty) {
+                write_value(os, columns[c].type, zone.min);
+                write_value(os, columns[c].type, zone.max);
+            }
+            write_uint64(os, zone.distinctSketch);
+        }
+    }
+}
+
+// Returns no maps if they were written for a different segment size; the load then computes them.
+std::vector<std::vector<ZoneMap>> readZoneSection(std::istream& is, const std::vector<Column>& columns) {
+    const uint32_t segmentRows = read_uint32(is);
+    std::vector<std::vector<ZoneMap>> zones(read_uint32(is), std::vector<ZoneMap>(columns.size()));
+    for (auto& segment : zones) {
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+            ZoneMap& zone = segment[c];
+            zone.empty = read_uint8(is) == 0;
+            if (!zone.empty) {
+                zone.min = read_value(is, columns[c].type);
+                zone.max = read_value(is, columns[c].type);
+            }
+            zone.distinctSketch = read_uint64(is);
+        }
+    }
+    if (segmentRows != Table::kSegmentRows) zones.clear();
+    return zones;
+}
+
+void readRows(std::istream& is, Table& table, std::uint64_t count, ThreadPool& pool) {
+    const auto& columns = table.schema().getColumns();
+    std::vector<Record> rows;
+    rows.reserve(count);
+    for (std::uint64_t r = 0; r < count; ++r)
+        rows.push_back(read_record(is, columns));
+    table.bulkLoad(std::move(rows), &pool);
+}
+}
+
 void Database::createTable(const TableSchema& schema) {
-    if (tables.contains(schema.name())) {
+    std::unique_lock lock(tablesMutex);
+    if (tables.contains(schema.name()) || pendingTables.contains(schema.name())) {
         throw std::runtime_error("Table already exists: " + schema.name());
     }
     tables[schema.name()] = std::make_unique<Table>(schema);
 }
 
-Table* Database::getTable(const std::string& name) {
-    const auto it = tables.find(name);
-    if (it == tables.end())
-        throw std::runtime_error("Table '" + name + "' does not exist.");
-    return it->second.get();
+Table* Database::getTable(std::string_view name) {
+    {
+        std::shared_lock lock(tablesMutex);
+        const auto it = tables.find(name);
+        if (it != tables.end()) return it->second.get();
+    }
+    return materialize(name);
 }
 
-bool Database::saveToFile(const std::filesystem::path& path) const {
-    std::ofstream ofs(path, std::ios::binary);
-    if (!ofs) return false;
+bool Database::hasTable(std::string_view name) const {
+    std::shared_lock lock(tablesMutex);
+    return tables.find(name) != tables.end() || pendingTables.find(name) != pendingTables.end();
+}
+
+std::size_t Database::pendingTableCount() const {
+    std::shared_lock lock(tablesMutex);
+    return pendingTables.size();
+}
+
+ThreadPool& Database::loadPool() const {
+    std::call_once(loadPoolOnce, [this] { loadPoolPtr = std::make_unique<ThreadPool>(); });
+    return *loadPoolPtr;
+}
+
+std::unique_ptr<Table> Database::decodeTable(const std::string& name, const PendingTable& entry) const {
+    auto corrupt = [&] { return std::runtime_error("Corrupt table '" + name + "' in " + sourcePath.string()); };
+    std::ifstream ifs(sourcePath, std::ios::binary);
+    if (!ifs) throw std::runtime_error("Failed to open file for reading: " + sourcePath.string());
+    ifs.seekg(static_cast<std::streamoff>(entry.offset));
+    auto table = std::make_unique<Table>(entry.schema);
+    readBloomSection(ifs, *table);
+
+    // Block b holds rows [b * blockRows, ...) and ends where block b + 1 (or the index) starts.
+    std::uint64_t blockRows = std::max<std::uint64_t>(entry.rows, 1);
+    std::vector<std::uint64_t> starts{static_cast<std::uint64_t>(ifs.tellg())};
+    const std::uint64_t bodyEnd = entry.offset + entry.length;
+    std::uint64_t rowsEnd = bodyEnd;
+    if (entry.blocksOffset != 0) {
+        ifs.seekg(static_cast<std::streamoff>(entry.blocksOffset));
+        blockRows = read_uint32(ifs);
+        starts.resize(read_uint32(ifs));
+        for (auto& start : starts) start = read_uint64(ifs);
+        const std::uint64_t indexEnd = entry.zonesOffset != 0 ? entry.zonesOffset : bodyEnd;
+        if (!ifs || static_cast<std::uint64_t>(ifs.tellg()) != indexEnd || blockRows == 0 ||
+            starts.size() != (entry.rows + blockRows - 1) / blockRows)
+            throw corrupt();
+        rowsEnd = entry.blocksOffset;
+    }
+    if (!ifs) throw corrupt();
+
+    const auto& columns = entry.schema.getColumns();
+    std::vector<std::vector<ZoneMap>> zones;
+    if (entry.zonesOffset != 0) {
+        zones = readZoneSection(ifs, columns);
+        if (!ifs || static_cast<std::uint64_t>(ifs.tellg()) != bodyEnd) throw corrupt();
+        if (entry.schema.engine() == TableEngine::Lsm) zones.clear();
+        if (!zones.empty() && zones.size() != (entry.rows + Table::kSegmentRows - 1) / Table::kSegmentRows)
+            throw corrupt();
+    }
+    std::vector<Record> rows(entry.rows);
+    loadPool().parallelFor(entry.rows == 0 ? 0 : starts.size(), [&](std::size_t b) {
+        std::ifstream block(sourcePath, std::ios::binary);
+        block.seekg(static_cast<std::streamoff>(starts[b]));
+        const std::uint64_t first = b * blockRows;
+        const std::uint64_t last = std::min<std::uint64_t>(entry.rows, first + blockRows);
+        for (std::uint64_t r = first; r < last; ++r) rows[r] = read_record(block, columns);
+        const std::uint64_t end = b + 1 < starts.size() ? starts[b + 1] : rowsEnd;
+        if (!block || static_cast<std::uint64_t>(block.tellg()) != end) throw corrupt();
+    });
+    table->bulkLoad(std::move(rows), &loadPool(), std::move(zones));
+    return table;
+}
+
+Table* Database::materialize(std::string_view name) const {
+    // One table is decoded at a time (its row blocks in parallel); lookups of loaded tables are not held up.
+    std::lock_guard load(loadMutex);
+    std::optional<PendingTable> entry;
+    {
+        std::shared_lock lock(tablesMutex);
+        if (const auto it = tables.find(name); it != tables.end()) return it->second.get();
+        const auto it = pendingTables.find(name);
+        if (it == pendingTables.end())
+            throw std::runtime_error("Table '" + std::string(name) + "' does not exist.");
+        entry = it->second;
+    }
+    auto table = decodeTable(std::string(name), *entry);
+
+    std::unique_lock lock(tablesMutex);
+    Table* raw = table.get();
+    tables.emplace(std::string(name), std::move(table));
+    pendingTables.erase(pendingTables.find(name));
+    return raw;
+}
+
+void Database::materializeAll() const {
+    std::lock_guard load(loadMutex);
+    std::vector<std::pair<std::string, PendingTable>> pending;
+    {
+        std::shared_lock lock(tablesMutex);
+        pending.assign(pendingTables.begin(), pendingTables.end());
+    }
+    if (pending.empty()) return;
+    std::vector<std::unique_ptr<Table>> decoded(pending.size());
+    loadPool().parallelFor(pending.size(), [&](std::size_t t) {
+        decoded[t] = decodeTable(pending[t].first, pending[t].second);
+    });
+
+    std::unique_lock lock(tablesMutex);
+    for (std::size_t t = 0; t < pending.size(); ++t) {
+        tables.emplace(pending[t].first, std::move(decoded[t]));
+        pendingTables.erase(pendingTables.find(pending[t].first));
+    }
+}
+
+void Database::loadAllTables() {
+    materializeAll();
+}
+
+std::vector<TableSnapshot> Database::captureSnapshots() const {
+    // A snapshot covers every table, so anything still on disk is loaded first.
+    materializeAll();
+    std::shared_lock lock(tablesMutex);
+    // Hold every table's shared lock at once so the cut is consistent across tables;
+    // writers are only held off for the segment-list copies below.
+    std::vector<std::shared_lock<std::shared_mutex>> held;
+    held.reserve(tables.size());
+    for (const auto& [name, tablePtr] : tables)
+        held.push_back(tablePtr->lockShared());
+    std::vector<TableSnapshot> snapshots;
+    snapshots.reserve(tables.size());
+    std::size_t i = 0;
+    for (const auto& [name, tablePtr] : tables)
+        snapshots.push_back(tablePtr->snapshot(held[i++]));
+    return snapshots;
+}
 
+void Database::writeSnapshots(std::ostream& ofs, const std::vector<TableSnapshot>& snapshots, CheckpointStats* progress,
+                              std::mutex* progressMutex) {
     // Write magic and version
     ofs.write("MARI", 4);
-    write_uint8(ofs, 1);
+    write_uint8(ofs, kFileVersion);
 
     // Table count
-    write_uint32(ofs, static_cast<uint32_t>(tables.size()));
-
-    for (const auto& [name, tablePtr] : tables) {
-        // Table name
-        write_string(ofs, tablePtr->schema().name());
-        // Columns
-        const auto& columns = tablePtr->schema().getColumns();
-        write_uint16(ofs, static_cast<uint16_t>(columns.size()));
-        for (const auto& col : columns) {
-            write_string(ofs, col.name);
-            write_uint8(ofs, static_cast<uint8_t>(col.type));
-        }
-        // Records
-        const auto& records = tablePtr->getRecords();
-        write_uint32(ofs, static_cast<uint32_t>(records.size()));
-        for (const auto& record : records) {
-            for (const auto& col : columns) {
-                const auto& value = record.at(col.name);
-                if (col.type == DataType::Integer) {
-                    write_uint32(ofs, static_cast<uint32_t>(std::get<int>(value)));
-                } else if (col.type == DataType::Float) {
-                    float f = std::get<float>(value);
-                    ofs.write(reinterpret_cast<char*>(&f), sizeof(float));
-                } else {
-                    write_string(ofs, std::get<std::string>(value));
-                }
+    write_uint32(ofs, static_cast<uint32_t>(snapshots.size()));
+
+    std::uint64_t rowsSinceReport = 0;
+    auto report = [&] {
+        if (!progress || rowsSinceReport == 0) return;
+        std::lock_guard lock(*progressMutex);
+        progress->rowsWritten += rowsSinceReport;
+        progress->bytesWritten = static_cast<std::uint64_t>(ofs.tellp());
+        rowsSinceReport = 0;
+    };
+
+    // Table directory (v4): schema, then body offset, length, row count, (v5) block index offset and
+    // (v7) zone map offset, patched once the bodies are written.
+    std::vector<std::streampos> extentPos;
+    for (const auto& snap : snapshots) {
+        writeSchema(ofs, snap.schema());
+        extentPos.push_back(ofs.tellp());
+        for (int i = 0; i < 5; ++i) write_uint64(ofs, 0);
+    }
+
+    // Table bodies: Bloom section, the records, where each block of kLoadBlockRows records starts,
+    // then the zone maps of each kSegmentRows records (the segments the load will rebuild).
+    for (std::size_t t = 0; t < snapshots.size(); ++t) {
+        const auto& snap = snapshots[t];
+        const auto& columns = snap.schema().getColumns();
+        const bool heap = snap.schema().engine() != TableEngine::Lsm;
+        const auto offset = ofs.tellp();
+        writeBloomSection(ofs, snap);
+        std::uint64_t written = 0;
+        std::vector<std::uint64_t> blockStarts;
+        std::vector<std::vector<ZoneMap>> zones;
+        snap.forEachRecord([&](const Record& record) {
+            if (written % kLoadBlockRows == 0) blockStarts.push_back(static_cast<std::uint64_t>(ofs.tellp()));
+            write_record(ofs, columns, record);
+            if (heap) {
+                if (written % Table::kSegmentRows == 0) zones.emplace_back(columns.size());
+                for (std::size_t c = 0; c < columns.size(); ++c) zones.back()[c].add(record.at(columns[c].name));
             }
-        }
+            written++;
+            if (++rowsSinceReport == Table::kSegmentRows) report();
+        });
+        const auto blocksOffset = ofs.tellp();
+        write_uint32(ofs, static_cast<uint32_t>(kLoadBlockRows));
+        write_uint32(ofs, static_cast<uint32_t>(blockStarts.size()));
+        for (auto start : blockStarts) write_uint64(ofs, start);
+        const auto zonesOffset = ofs.tellp();
+        writeZoneSection(ofs, columns, zones);
+        const auto end = ofs.tellp();
+        ofs.seekp(extentPos[t]);
+        write_uint64(ofs, static_cast<std::uint64_t>(offset));
+        write_uint64(ofs, static_cast<std::uint64_t>(end - offset));
+        write_uint64(ofs, written);
+        write_uint64(ofs, static_cast<std::uint64_t>(blocksOffset));
+        write_uint64(ofs, static_cast<std::uint64_t>(zonesOffset));
+        ofs.seekp(end);
     }
+    report();
+}
+
+void Database::writeFileAtomically(const std::filesystem::path& path, const std::vector<TableSnapshot>& snapshots,
+                                   CheckpointStats* progress, std::mutex* progressMutex) {
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs) throw std::runtime_error("Failed to open file for writing: " + tmp.string());
+        writeSnapshots(ofs, snapshots, progress, progressMutex);
+        ofs.flush();
+        if (!ofs) throw std::runtime_error("Write failed: " + tmp.string());
+    }
+    // The data must be durable before the rename makes it the file; a crash then leaves either
+    // the old or the new contents at 'path', never a torn file.
+    syncToDisk(tmp);
+    std::filesystem::rename(tmp, path);
+#ifndef _WIN32
+    // Persist the rename itself (the directory entry).
+    syncToDisk(path.has_parent_path() ? path.parent_path() : std::filesystem::path("."));
+#endif
+}
+
+bool Database::saveToFile(const std::filesystem::path& path) const {
+    // Snapshot before opening anything: tables not loaded yet are still read from sourcePath,
+    // which may be 'path' itself.
+    try {
+        writeFileAtomically(path, captureSnapshots(), nullptr, nullptr);
+        return true;
+    } catch (const std::exception& ex) {
+        std::cerr << "Save failed: " << ex.what() << "\n";
+        return false;
+    }
+}
+
+bool Database::checkpoint(const std::filesystem::path& path) {
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard lock(checkpointMutex);
+        if (lastCheckpoint.running) return false;
+        lastCheckpoint.running = true;
+    }
+    // The previous checkpointer has already cleared 'running', so this join does not block for long.
+    if (checkpointer.joinable()) checkpointer.join();
+
+    std::vector<TableSnapshot> snapshots;
+    try {
+        snapshots = captureSnapshots();
+    } catch (const std::exception& ex) {
+        // E.g. a table that fails to decode: no checkpointer will clear 'running' for this one.
+        std::lock_guard lock(checkpointMutex);
+        lastCheckpoint.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        lastCheckpoint.lastError = ex.what();
+        lastCheckpoint.running = false;
+        throw;
+    }
+    const auto captured = std::chrono::steady_clock::now();
+    std::uint64_t total = 0;
+    for (const auto& snap : snapshots) total += snap.liveRowCount();
+    {
+        std::lock_guard lock(checkpointMutex);
+        lastCheckpoint.rowsWritten = 0;
+        lastCheckpoint.bytesWritten = 0;
+        lastCheckpoint.rowsTotal = total;
+        lastCheckpoint.captureTime = std::chrono::duration_cast<std::chrono::microseconds>(captured - start);
+        lastCheckpoint.lastError.clear();
+    }
+
+    checkpointer = std::jthread([this, path, start, snapshots = std::move(snapshots)] {
+        std::string error;
+        try {
+            writeFileAtomically(path, snapshots, &lastCheckpoint, &checkpointMutex);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        std::lock_guard lock(checkpointMutex);
+        lastCheckpoint.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        lastCheckpoint.lastError = std::move(error);
+        if (lastCheckpoint.lastError.empty()) lastCheckpoint.completed++;
+        lastCheckpoint.running = false;
+    });
     return true;
 }
 
+void Database::waitForCheckpoint() {
+    // Only the thread that starts checkpoints reassigns 'checkpointer', so joining here is safe from that thread.
+    if (checkpointer.joinable()) checkpointer.join();
+}
+
+CheckpointStats Database::checkpointStats() const {
+    std::lock_guard lock(checkpointMutex);
+    return lastCheckpoint;
+}
+
 std::unique_ptr<Database> Database::loadFromFile(const std::filesystem::path& path) {
     std::ifstream ifs(path, std::ios::binary);
     if (!ifs) throw std::runtime_error("Failed to open file for reading: " + path.string());
@@ -74,41 +463,32 @@ std::unique_ptr<Database> Database::loadFromFile(const std::filesystem::path& pa
         return nullptr;
     }
     uint8_t version = read_uint8(ifs);
-    if (version != 1) {
+    if (version < 1 || version > kFileVersion) {
         std::cerr << "Unsupported MarinaDB file version!\n";
         return nullptr;
     }
     auto db = std::make_unique<Database>();
     uint32_t table_count = read_uint32(ifs);
-    for (uint32_t t = 0; t < table_count; ++t) {
-        std::string table_name = read_string(ifs);
-        uint16_t column_count = read_uint16(ifs);
-        std::vector<Column> columns;
-        for (uint16_t c = 0; c < column_count; ++c) {
-            std::string col_name = read_string(ifs);
-            DataType col_type = static_cast<DataType>(read_uint8(ifs));
-            columns.push_back({col_name, col_type});
+    if (version >= 4) {
+        // Only the directory is read here; getTable decodes a table from its extent on first use.
+        for (uint32_t t = 0; t < table_count; ++t) {
+            TableSchema schema = readSchema(ifs, version);
+            PendingTable entry{schema, read_uint64(ifs), read_uint64(ifs), read_uint64(ifs)};
+            if (version >= 5) entry.blocksOffset = read_uint64(ifs);
+            if (version >= 7) entry.zonesOffset = read_uint64(ifs);
+            if (!ifs) throw std::runtime_error("Corrupt table directory in " + path.string());
+            db->pendingTables.emplace(schema.name(), std::move(entry));
         }
-        TableSchema schema(table_name, columns);
+        db->sourcePath = path;
+        return db;
+    }
+    // Older files have no directory: tables are stored back to back and must be decoded in order.
+    for (uint32_t t = 0; t < table_count; ++t) {
+        TableSchema schema = readSchema(ifs, version);
         db->createTable(schema);
-        Table* table = db->getTable(table_name);
-
-        uint32_t record_count = read_uint32(ifs);
-        for (uint32_t r = 0; r < record_count; ++r) {
-            Record rec;
-            for (const auto& col : columns) {
-                if (col.type == DataType::Integer) {
-                    rec[col.name] = static_cast<int>(read_uint32(ifs));
-                } else if (col.type == DataType::Float) {
-                    float f;
-                    ifs.read(reinterpret_cast<char*>(&f), sizeof(float));
-                    rec[col.name] = f;
-                } else {
-                    rec[col.name] = read_string(ifs);
-                }
-            }
-            table->insert(rec);
-        }
+        Table* table = db->getTable(schema.name());
+        if (version >= 2) readBloomSection(ifs, *table);
+        readRows(ifs, *table, read_uint32(ifs), db->loadPool());
     }
     return db;
-}
\ No newline at end of file
+}
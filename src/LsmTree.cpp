@@ -0,0 +1,685 @@
+#include "LsmTree.h"
+#include "RecordIO.h"
+#include "KeyCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// One sparse-index entry per this many run entries; a point read decodes at most this many.
+constexpr std::size_t kIndexInterval = 64;
+constexpr std::uint8_t kTombstone = 0;
+constexpr std::uint8_t kLiveRecord = 1;
+// Run files are read and written in blocks of about this size.
+constexpr std::size_t kIoBlockBytes = 256 * 1024;
+
+// Entries are kept encoded, in memtables and run files alike:
+//   [u8 flag][key][u32 payload size][payload = record (RecordIO.h), empty for a tombstone]
+// so flushes and merges move bytes and only reads decode records.
+struct EntryRef {
+    Value key;
+    bool live = false;
+    std::string_view payload;
+    std::string_view encoded;   // the whole entry as stored, so it can be copied without re-encoding
+};
+
+// Length of the encoded key at the front of 'in', or 0 if 'in' is too short to tell.
+std::size_t encodedKeySize(std::string_view in, DataType keyType) {
+    if (keyType != DataType::String) return in.size() >= sizeof(std::uint32_t) ? sizeof(std::uint32_t) : 0;
+    std::uint16_t len;
+    if (in.size() < sizeof len) return 0;
+    std::memcpy(&len, in.data(), sizeof len);
+    return sizeof len + len;
+}
+
+// Parses the entry at the front of 'in' and advances past it; false (with 'in' untouched) if it is incomplete.
+bool parseEntry(std::string_view& in, DataType keyType, EntryRef& entry) {
+    const std::size_t keySize = in.empty() ? 0 : encodedKeySize(in.substr(1), keyType);
+    const std::size_t header = 1 + keySize + sizeof(std::uint32_t);
+    if (keySize == 0 || in.size() < header) return false;
+    std::uint32_t size;
+    std::memcpy(&size, in.data() + 1 + keySize, sizeof size);
+    if (in.size() < header + size) return false;
+    entry.live = in[0] == static_cast<char>(kLiveRecord);
+    std::string_view key = in.substr(1, keySize);
+    entry.key = parse_value(key, keyType);
+    entry.payload = in.substr(header, size);
+    entry.encoded = in.substr(0, header + size);
+    in.remove_prefix(header + size);
+    return true;
+}
+}
+
+// -- MEMTABLE --
+// Append-only arena of encoded entries plus one slot per entry: an order-preserving 8-byte prefix
+// of its key and the entry's offset. A put is one append to each and never searches: slots
+// [0, sortedCount) are in key order (newest entry of a key first), the rest are in arrival order.
+// The tail is sorted and merged in when the memtable is frozen, or when a read would otherwise
+// have to search more than kMaxUnsortedTail entries linearly. Only a holder of the tree's unique
+// lock changes a memtable.
+struct LsmMemtable {
+    struct Slot {
+        std::uint64_t prefix;
+        std::uint64_t offset;
+    };
+    // Longest tail a read searches linearly (point reads) or sorts a copy of (scans).
+    static constexpr std::size_t kMaxUnsortedTail = 256;
+
+    explicit LsmMemtable(DataType keyType) : keyType(keyType) {}
+
+    void put(const Value& key, const Record* record, const std::vector<Column>& columns) {
+        const auto offset = arena.size();
+        arena.push_back(static_cast<char>(record ? kLiveRecord : kTombstone));
+        append_value(arena, keyType, key);
+        const auto sizePos = arena.size();
+        arena.append(sizeof(std::uint32_t), '\0');
+        if (record) append_record(arena, columns, *record);
+        const auto size = static_cast<std::uint32_t>(arena.size() - sizePos - sizeof(std::uint32_t));
+        std::memcpy(&arena[sizePos], &size, sizeof size);
+        slots.push_back({keyPrefix(key), offset});
+    }
+
+    // Sorts the tail and merges it into the sorted slots.
+    void sortTail() {
+        if (sortedCount == slots.size()) return;
+        // Prefixes are whole keys unless the keys are strings: then the slots sort as plain integers.
+        if (keyType != DataType::String) {
+            mergeTail([](const Slot& a, const Slot& b) { return a.prefix != b.prefix ? a.prefix < b.prefix : a.offset > b.offset; });
+        } else {
+            mergeTail([&](const Slot& a, const Slot& b) { return slotLess(a, b); });
+        }
+        sortedCount = slots.size();
+    }
+
+    std::optional<EntryRef> find(const Value& key) const {
+        const std::uint64_t prefix = keyPrefix(key);
+        // The tail is newer than every sorted slot; its last match is the latest entry.
+        for (std::size_t i = slots.size(); i-- > sortedCount;) {
+            if (compare(slots[i], key, prefix) == 0) return entryAt(slots[i].offset);
+        }
+        const std::size_t i = lowerBound(sorted(), key);
+        if (i == sortedCount || compare(slots[i], key, prefix) != 0) return std::nullopt;
+        return entryAt(slots[i].offset);
+    }
+
+    EntryRef entryAt(std::size_t offset) const {
+        std::string_view in(arena);
+        in.remove_prefix(offset);
+        EntryRef entry;
+        parseEntry(in, keyType, entry);
+        return entry;
+    }
+
+    [[nodiscard]] std::span<const Slot> sorted() const { return {slots.data(), sortedCount}; }
+    [[nodiscard]] std::span<const Slot> tail() const { return std::span<const Slot>(slots).subspan(sortedCount); }
+    // Index of the first slot of 'range' with key >= key.
+    [[nodiscard]] std::size_t lowerBound(std::span<const Slot> range, const Value& key) const {
+        const std::uint64_t prefix = keyPrefix(key);
+        return static_cast<std::size_t>(std::partition_point(range.begin(), range.end(), [&](const Slot& slot) {
+            return compare(slot, key, prefix) < 0;
+        }) - range.begin());
+    }
+    // Key order, then newest first among entries of the same key.
+    [[nodiscard]] bool slotLess(const Slot& a, const Slot& b) const {
+        const int c = compareKeys(a, b);
+        return c != 0 ? c < 0 : a.offset > b.offset;
+    }
+    [[nodiscard]] bool sameKey(const Slot& a, const Slot& b) const { return compareKeys(a, b) == 0; }
+
+    // Entries, overwrites and deletes of the same key included.
+    [[nodiscard]] std::size_t entryCount() const { return slots.size(); }
+    [[nodiscard]] std::size_t unsortedCount() const { return slots.size() - sortedCount; }
+    [[nodiscard]] std::size_t bytes() const { return arena.size() + slots.size() * sizeof(Slot); }
+    [[nodiscard]] bool empty() const { return slots.empty(); }
+
+private:
+    DataType keyType;
+    std::string arena;
+    std::vector<Slot> slots;
+    std::size_t sortedCount = 0;
+
+    template<typename Less>
+    void mergeTail(Less less) {
+        const auto middle = slots.begin() + static_cast<std::ptrdiff_t>(sortedCount);
+        std::sort(middle, slots.end(), less);
+        std::inplace_merge(slots.begin(), middle, slots.end(), less);
+    }
+
+    // First 8 bytes of the key's memcomparable encoding (KeyCodec.h), big-endian, zero-padded:
+    // prefixes order like the keys, and equal prefixes mean equal keys for ints and floats.
+    std::uint64_t keyPrefix(const Value& key) const {
+        std::string encoded;
+        if (const auto* str = std::get_if<std::string>(&key)) encoded.assign(*str, 0, 8);
+        else appendKeyPart(encoded, key);
+        std::uint64_t prefix = 0;
+        for (std::size_t i = 0; i < 8; ++i)
+            prefix = prefix << 8 | (i < encoded.size() ? static_cast<unsigned char>(encoded[i]) : 0);
+        return prefix;
+    }
+
+    std::string_view stringKey(const Slot& slot) const {
+        std::string_view in(arena);
+        in.remove_prefix(slot.offset + 1);
+        std::uint16_t len;
+        std::memcpy(&len, in.data(), sizeof len);
+        return in.substr(sizeof len, len);
+    }
+
+    // Orders the key of 'slot' against 'key'; string keys with equal prefixes are compared in the arena.
+    int compare(const Slot& slot, const Value& key, std::uint64_t prefix) const {
+        if (slot.prefix != prefix) return slot.prefix < prefix ? -1 : 1;
+        if (keyType != DataType::String) return 0;
+        return stringKey(slot).compare(std::get<std::string>(key));
+    }
+    int compareKeys(const Slot& a, const Slot& b) const {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix ? -1 : 1;
+        if (keyType != DataType::String) return 0;
+        return stringKey(a).compare(stringKey(b));
+    }
+};
+
+// -- RUN --
+// Immutable sorted file of encoded entries, with min/max key, a sparse offset index and a key
+// Bloom filter kept in memory. The file is deleted with the object.
+class LsmRun {
+public:
+    LsmRun(std::filesystem::path path, DataType keyType) : file(std::move(path)), keyType(keyType) {}
+
+    ~LsmRun() {
+        reader.close();
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+    }
+
+    // True if the run holds an entry for key; 'block' keeps the bytes 'entry' points into.
+    bool lookup(const Value& key, EntryRef& entry, std::string& block, std::atomic<std::uint64_t>& bloomProbes,
+                std::atomic<std::uint64_t>& bloomNegatives) const {
+        if (entries == 0 || key < minKey || maxKey < key) return false;
+        bloomProbes.fetch_add(1, std::memory_order_relaxed);
+        if (!bloom.mayContain(bloomHash(key))) {
+            bloomNegatives.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto it = std::upper_bound(sparse.begin(), sparse.end(), key,
+                                   [](const Value& k, const auto& e) { return k < e.first; });
+        if (it == sparse.begin()) return false;
+        const std::uint64_t begin = std::prev(it)->second;
+        const std::uint64_t end = it != sparse.end() ? it->second : bytes;
+        block.resize(end - begin);
+        {
+            std::lock_guard lock(readMutex);
+            if (!reader.is_open()) {
+                reader.open(file, std::ios::binary);
+                if (!reader.is_open()) throw std::runtime_error("Cannot open LSM run file: " + file.string());
+            }
+            reader.clear();
+            reader.seekg(static_cast<std::streamoff>(begin));
+            reader.read(block.data(), static_cast<std::streamsize>(block.size()));
+            if (!reader) throw std::runtime_error("Corrupt LSM run file: " + file.string());
+        }
+        std::string_view in(block);
+        while (parseEntry(in, keyType, entry)) {
+            if (entry.key == key) return true;
+            if (key < entry.key) return false;
+        }
+        return false;
+    }
+
+    std::filesystem::path file;
+    DataType keyType;
+    std::size_t entries = 0;
+    std::uint64_t bytes = 0;
+    Value minKey, maxKey;
+    BlockedBloomFilter bloom;
+    std::vector<std::pair<Value, std::uint64_t>> sparse;    // every kIndexInterval-th key -> file offset
+
+private:
+    mutable std::mutex readMutex;
+    mutable std::ifstream reader;
+};
+
+// -- MERGE --
+namespace {
+struct Cursor {
+    virtual ~Cursor() = default;
+    virtual bool valid() const = 0;
+    virtual const EntryRef& entry() const = 0;
+    virtual void next() = 0;
+};
+
+// Walks the sorted slots and a sorted copy of the (short) tail together; the first slot of each
+// key in that order is its newest entry, and the others are skipped.
+struct MemCursor : Cursor {
+    using Slot = LsmMemtable::Slot;
+    const LsmMemtable& mem;
+    std::span<const Slot> sorted;
+    std::vector<Slot> tail;
+    std::size_t i = 0, j = 0;
+    const Slot* slot = nullptr;
+    EntryRef current;
+
+    MemCursor(const LsmMemtable& m, const std::optional<Value>& lower)
+        : mem(m), sorted(m.sorted()), tail(m.tail().begin(), m.tail().end()) {
+        std::sort(tail.begin(), tail.end(), [&](const Slot& a, const Slot& b) { return mem.slotLess(a, b); });
+        if (lower) {
+            i = mem.lowerBound(sorted, *lower);
+            j = mem.lowerBound(tail, *lower);
+        }
+        load();
+    }
+    bool valid() const override { return slot != nullptr; }
+    const EntryRef& entry() const override { return current; }
+    void next() override {
+        const Slot key = *slot;
+        while (i < sorted.size() && mem.sameKey(sorted[i], key)) ++i;
+        while (j < tail.size() && mem.sameKey(tail[j], key)) ++j;
+        load();
+    }
+    void load() {
+        const bool fromSorted = i < sorted.size(), fromTail = j < tail.size();
+        if (!fromSorted && !fromTail) {
+            slot = nullptr;
+            return;
+        }
+        slot = !fromTail || (fromSorted && mem.slotLess(sorted[i], tail[j])) ? &sorted[i] : &tail[j];
+        current = mem.entryAt(slot->offset);
+    }
+};
+
+struct RunCursor : Cursor {
+    const LsmRun& run;
+    std::ifstream in;
+    std::string buffer;
+    std::size_t pos = 0;
+    bool ok = false;
+    EntryRef current;
+
+    RunCursor(const LsmRun& r, const std::optional<Value>& lower) : run(r), in(r.file, std::ios::binary) {
+        if (!in.is_open()) throw std::runtime_error("Cannot open LSM run file: " + run.file.string());
+        if (lower && !run.sparse.empty()) {
+            // Start at the last indexed entry <= lower, then step forward.
+            auto it = std::upper_bound(run.sparse.begin(), run.sparse.end(), *lower,
+                                       [](const Value& v, const auto& entry) { return v < entry.first; });
+            if (it != run.sparse.begin()) in.seekg(static_cast<std::streamoff>(std::prev(it)->second));
+        }
+        next();
+        while (ok && lower && current.key < *lower) next();
+    }
+    bool valid() const override { return ok; }
+    const EntryRef& entry() const override { return current; }
+    void next() override {
+        while (true) {
+            std::string_view rest(buffer);
+            rest.remove_prefix(pos);
+            if ((ok = parseEntry(rest, run.keyType, current))) {
+                pos = buffer.size() - rest.size();
+                return;
+            }
+            if (!in) {
+                if (!rest.empty()) throw std::runtime_error("Corrupt LSM run file: " + run.file.string());
+                return;
+            }
+            // Keep the partial entry and append the next block after it.
+            buffer.erase(0, pos);
+            pos = 0;
+            const auto kept = buffer.size();
+            buffer.resize(kept + std::max(kIoBlockBytes, kept));
+            in.read(buffer.data() + kept, static_cast<std::streamsize>(buffer.size() - kept));
+            buffer.resize(kept + static_cast<std::size_t>(in.gcount()));
+        }
+    }
+};
+
+// Merges sources given newest first; for each key only the newest entry is passed to emit.
+// A min-heap on (key, source rank) keeps this O(log sources) per entry.
+template<typename Emit>
+void mergeSources(const std::vector<const LsmMemtable*>& memtables, const std::vector<const LsmRun*>& runs,
+                  const std::optional<Value>& lower, const std::optional<Value>& upper, Emit&& emit) {
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    for (const auto* mem : memtables) cursors.push_back(std::make_unique<MemCursor>(*mem, lower));
+    for (const auto* run : runs) cursors.push_back(std::make_unique<RunCursor>(*run, lower));
+    // std heaps are max-heaps, so 'after' orders a source after b when it should be popped later.
+    auto after = [&](std::size_t a, std::size_t b) {
+        const Value& ka = cursors[a]->entry().key;
+        const Value& kb = cursors[b]->entry().key;
+        return kb < ka || (ka == kb && a > b);
+    };
+    std::vector<std::size_t> heap;
+    for (std::size_t i = 0; i < cursors.size(); ++i) {
+        if (cursors[i]->valid()) heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), after);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        Cursor& winner = *cursors[heap.back()];
+        if (upper && !(winner.entry().key < *upper)) return;
+        if (!emit(winner.entry())) return;
+        // Older entries for the same key are shadowed; step past them before the winner moves on.
+        while (heap.size() > 1 && cursors[heap.front()]->entry().key == winner.entry().key) {
+            std::pop_heap(heap.begin(), heap.end() - 1, after);
+            const std::size_t older = heap[heap.size() - 2];
+            cursors[older]->next();
+            if (cursors[older]->valid()) {
+                std::push_heap(heap.begin(), heap.end() - 1, after);
+            } else {
+                heap.erase(heap.end() - 2);
+            }
+        }
+        winner.next();
+        if (winner.valid()) {
+            std::push_heap(heap.begin(), heap.end(), after);
+        } else {
+            heap.pop_back();
+        }
+    }
+}
+}
+
+// -- TREE --
+
+LsmTree::LsmTree(std::vector<Column> cols, std::string keyColumn, LsmOptions opts)
+    : columns(std::move(cols)), key(std::move(keyColumn)), options(std::move(opts))
+{
+    auto it = std::find_if(columns.begin(), columns.end(), [&](const Column& c) { return c.name == key; });
+    if (it == columns.end()) throw std::runtime_error("LSM key column not in schema: " + key);
+    keyType = it->type;
+    if (options.directory.empty()) {
+        std::random_device rd;
+        std::ostringstream name;
+        name << "marinadb-lsm-" << std::hex << rd() << rd();
+        options.directory = std::filesystem::temp_directory_path() / name.str();
+        ownsDirectory = true;
+    }
+    std::filesystem::create_directories(options.directory);
+    active = std::make_shared<LsmMemtable>(keyType);
+    worker = std::jthread([this] {
+        std::unique_lock lock(treeMutex);
+        backgroundLoop(lock);
+    });
+}
+
+LsmTree::~LsmTree() {
+    {
+        std::unique_lock lock(treeMutex);
+        stopping = true;
+    }
+    workCv.notify_all();
+    if (worker.joinable()) worker.join();
+    levels.clear();
+    immutables.clear();
+    if (ownsDirectory) {
+        std::error_code ec;
+        std::filesystem::remove_all(options.directory, ec);
+    }
+}
+
+void LsmTree::put(const Record& record) {
+    write(record.at(key), &record);
+}
+
+void LsmTree::remove(const Value& k) {
+    write(k, nullptr);
+}
+
+void LsmTree::write(const Value& k, const Record* record) {
+    std::unique_lock lock(treeMutex);
+    // While flushes fail, writes still fill the memtable but fail instead of waiting once the queue is full.
+    workCv.wait(lock, [&] { return immutables.size() < options.maxImmutableMemtables || !backgroundError.empty(); });
+    if (immutables.size() >= options.maxImmutableMemtables)
+        throw std::runtime_error("LSM flush failed: " + backgroundError);
+    active->put(k, record, columns);
+    if (active->entryCount() >= options.memtableEntries || active->bytes() >= options.memtableBytes)
+        freezeActiveLocked();
+}
+
+std::shared_lock<std::shared_mutex> LsmTree::lockForRead() const {
+    std::shared_lock lock(treeMutex);
+    // Puts leave the active memtable's tail unsorted; past a few hundred entries a read sorts it first.
+    while (active->unsortedCount() > LsmMemtable::kMaxUnsortedTail) {
+        lock.unlock();
+        {
+            std::unique_lock writer(treeMutex);
+            active->sortTail();
+        }
+        lock.lock();
+    }
+    return lock;
+}
+
+std::optional<Record> LsmTree::get(const Value& k) const {
+    auto lock = lockForRead();
+    auto decode = [&](bool live, std::string_view payload) -> std::optional<Record> {
+        if (!live) return std::nullopt;
+        return parse_record(payload, columns);
+    };
+    if (auto e = active->find(k)) return decode(e->live, e->payload);
+    for (auto it = immutables.rbegin(); it != immutables.rend(); ++it) {
+        if (auto e = (*it)->find(k)) return decode(e->live, e->payload);
+    }
+    std::string block;
+    EntryRef entry;
+    for (const auto& level : levels) {
+        for (auto it = level.rbegin(); it != level.rend(); ++it) {
+            if ((*it)->lookup(k, entry, block, bloomProbes, bloomNegatives)) return decode(entry.live, entry.payload);
+        }
+    }
+    return std::nullopt;
+}
+
+void LsmTree::scan(const std::optional<Value>& lower, const std::optional<Value>& upper, const LsmVisitor& fn) const {
+    auto lock = lockForRead();
+    std::vector<const LsmMemtable*> memtables;
+    std::vector<const LsmRun*> runs;
+    collectSourcesLocked(memtables, runs);
+    mergeSources(memtables, runs, lower, upper, [&](const EntryRef& entry) {
+        return !entry.live || fn(parse_record(entry.payload, columns));
+    });
+}
+
+std::shared_ptr<const LsmView> LsmTree::view() {
+    std::unique_lock lock(treeMutex);
+    // Freezing makes every memtable immutable, so the view can share them without copying.
+    if (!active->empty()) freezeActiveLocked();
+    auto v = std::make_shared<LsmView>();
+    v->columns = columns;
+    for (auto it = immutables.rbegin(); it != immutables.rend(); ++it) v->memtables.push_back(*it);
+    for (const auto& level : levels) {
+        for (auto it = level.rbegin(); it != level.rend(); ++it) v->runs.push_back(*it);
+    }
+    return v;
+}
+
+void LsmView::scan(const LsmVisitor& fn) const {
+    std::vector<const LsmMemtable*> mems;
+    std::vector<const LsmRun*> rs;
+    for (const auto& m : memtables) mems.push_back(m.get());
+    for (const auto& r : runs) rs.push_back(r.get());
+    mergeSources(mems, rs, std::nullopt, std::nullopt, [&](const EntryRef& entry) {
+        return !entry.live || fn(parse_record(entry.payload, columns));
+    });
+}
+
+std::size_t LsmView::entryCount() const {
+    std::size_t n = 0;
+    for (const auto& m : memtables) n += m->entryCount();
+    for (const auto& r : runs) n += r->entries;
+    return n;
+}
+
+void LsmTree::compactAll() {
+    std::unique_lock lock(treeMutex);
+    if (!active->empty()) freezeActiveLocked();
+    majorRequested = true;
+    workCv.notify_all();
+    const auto failures = backgroundFailures;
+    workCv.wait(lock, [&] { return !majorRequested || backgroundFailures != failures; });
+    if (majorRequested) {
+        majorRequested = false;
+        throw std::runtime_error("LSM compaction failed: " + backgroundError);
+    }
+}
+
+LsmStats LsmTree::stats() const {
+    std::shared_lock lock(treeMutex);
+    LsmStats s;
+    s.memtableEntries = active->entryCount();
+    s.immutableMemtables = immutables.size();
+    s.levels = levels.size();
+    for (const auto& level : levels) {
+        s.runs += level.size();
+        for (const auto& run : level) s.bytesOnDisk += run->bytes;
+    }
+    s.flushes = flushes.load();
+    s.compactions = compactions.load();
+    s.bloomProbes = bloomProbes.load();
+    s.bloomNegatives = bloomNegatives.load();
+    s.backgroundFailures = backgroundFailures;
+    s.backgroundError = backgroundError;
+    return s;
+}
+
+void LsmTree::freezeActiveLocked() {
+    // Frozen memtables are read without the lock (flushes, views), so they are sorted once, here.
+    active->sortTail();
+    immutables.push_back(std::move(active));
+    active = std::make_shared<LsmMemtable>(keyType);
+    workCv.notify_all();
+}
+
+int LsmTree::levelToCompactLocked() const {
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].size() >= std::max<std::size_t>(options.runsPerLevel, 2)) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void LsmTree::collectSourcesLocked(std::vector<const LsmMemtable*>& memtables, std::vector<const LsmRun*>& runs) const {
+    memtables.push_back(active.get());
+    for (auto it = immutables.rbegin(); it != immutables.rend(); ++it) memtables.push_back(it->get());
+    for (const auto& level : levels) {
+        for (auto it = level.rbegin(); it != level.rend(); ++it) runs.push_back(it->get());
+    }
+}
+
+void LsmTree::backgroundLoop(std::unique_lock<std::shared_mutex>& lock) {
+    // Only this thread changes 'levels' and pops 'immutables', so inputs captured under the lock
+    // are still in place when the result is installed; file I/O runs with the lock released.
+    // A failed write (e.g. a full disk) leaves its inputs in place, so reads still see them, and
+    // the step is retried after a pause.
+    const auto writeUnlocked = [&](const std::vector<const LsmMemtable*>& memtables, const std::vector<const LsmRun*>& runs,
+                                   bool dropTombstones, std::shared_ptr<LsmRun>& run) {
+        std::string error;
+        lock.unlock();
+        try {
+            run = writeRun(memtables, runs, dropTombstones);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        lock.lock();
+        if (error.empty()) {
+            backgroundError.clear();
+            return true;
+        }
+        backgroundError = std::move(error);
+        backgroundFailures++;
+        workCv.notify_all();
+        workCv.wait_for(lock, kRetryDelay, [&] { return stopping; });
+        return false;
+    };
+
+    while (true) {
+        workCv.wait(lock, [&] {
+            return stopping || !immutables.empty() || levelToCompactLocked() >= 0 || majorRequested;
+        });
+        if (stopping) return;
+
+        std::shared_ptr<LsmRun> run;
+        if (!immutables.empty()) {
+            auto mem = immutables.front();
+            if (!writeUnlocked({mem.get()}, {}, false, run)) continue;
+            if (levels.empty()) levels.emplace_back();
+            if (run) levels[0].push_back(std::move(run));
+            immutables.pop_front();
+            flushes++;
+        } else if (int level = levelToCompactLocked(); level >= 0) {
+            const auto inputs = levels[level];
+            // Tombstones can go only if nothing older lies below the output level.
+            bool bottom = std::all_of(levels.begin() + level + 1, levels.end(), [](const auto& l) { return l.empty(); });
+            std::vector<const LsmRun*> newestFirst;
+            for (auto it = inputs.rbegin(); it != inputs.rend(); ++it) newestFirst.push_back(it->get());
+            if (!writeUnlocked({}, newestFirst, bottom, run)) continue;
+            levels[level].erase(levels[level].begin(), levels[level].begin() + static_cast<std::ptrdiff_t>(inputs.size()));
+            if (levels.size() <= static_cast<std::size_t>(level) + 1) levels.emplace_back();
+            if (run) levels[level + 1].push_back(std::move(run));
+            compactions++;
+        } else if (majorRequested) {
+            std::vector<const LsmRun*> all;
+            for (const auto& l : levels) {
+                for (auto it = l.rbegin(); it != l.rend(); ++it) all.push_back(it->get());
+            }
+            if (!all.empty()) {
+                if (!writeUnlocked({}, all, true, run)) continue;
+                levels.assign(2, {});
+                if (run) levels[1].push_back(std::move(run));
+                compactions++;
+            }
+            majorRequested = false;
+        }
+        workCv.notify_all();
+    }
+}
+
+std::shared_ptr<LsmRun> LsmTree::writeRun(const std::vector<const LsmMemtable*>& memtables,
+                                                const std::vector<const LsmRun*>& runs, bool dropTombstones) {
+    std::size_t expected = 0;
+    for (const auto* m : memtables) expected += m->entryCount();
+    for (const auto* r : runs) expected += r->entries;
+
+    auto path = options.directory / ("run-" + std::to_string(nextRunId++) + ".sst");
+    auto run = std::make_shared<LsmRun>(path, keyType);
+    run->bloom = BlockedBloomFilter(expected, options.bloomBitsPerKey);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to create LSM run file: " + path.string());
+    std::string block;
+    block.reserve(2 * kIoBlockBytes);
+
+    const auto add = [&](const EntryRef& entry) {
+        if (!entry.live && dropTombstones) return true;
+        const Value& k = entry.key;
+        if (run->entries % kIndexInterval == 0)
+            run->sparse.emplace_back(k, run->bytes + block.size());
+        block.append(entry.encoded);
+        if (block.size() >= kIoBlockBytes) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
+            run->bytes += block.size();
+            block.clear();
+        }
+        if (run->entries == 0) run->minKey = k;
+        run->maxKey = k;
+        run->bloom.add(bloomHash(k));
+        run->entries++;
+        return true;
+    };
+    if (runs.empty() && memtables.size() == 1 && memtables.front()->unsortedCount() == 0) {
+        // A flush: the frozen memtable is already in order, so only its older duplicates are skipped.
+        const LsmMemtable& mem = *memtables.front();
+        const auto slots = mem.sorted();
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            if (i > 0 && mem.sameKey(slots[i - 1], slots[i])) continue;
+            add(mem.entryAt(slots[i].offset));
+        }
+    } else {
+        mergeSources(memtables, runs, std::nullopt, std::nullopt, add);
+    }
+    out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    run->bytes += block.size();
+    out.close();
+    if (!out) throw std::runtime_error("Failed to write LSM run file: " + path.string());
+    if (run->entries == 0) return nullptr;  // everything was a dropped tombstone; ~LsmRun removes the file
+    return run;
+}
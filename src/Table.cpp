@@ -3,95 +3,1294 @@
 //
 
 #include "Table.h"
+#include "LsmTree.h"
+#include "ThreadPool.h"
+#include "KeyCodec.h"
+#include "RecordIO.h"
 #include <stdexcept>
 #include <utility>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <bit>
+#include <cmath>
+#include <set>
+#include <unordered_set>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <sstream>
+
+std::uint64_t bloomHash(const Value& value) {
+    return std::visit([](const auto& v) -> std::uint64_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, int>) {
+            return bloomHash(static_cast<std::uint64_t>(static_cast<std::uint32_t>(v)));
+        } else if constexpr (std::is_same_v<T, float>) {
+            // +0.0f and -0.0f compare equal, so they must hash equal.
+            float f = v == 0.0f ? 0.0f : v;
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof bits);
+            return bloomHash(static_cast<std::uint64_t>(bits) ^ 0xf10a7ULL << 32);
+        } else {
+            return bloomHash(std::string_view(v));
+        }
+    }, value);
+}
+
+bool ValueRange::contains(const Value& value) const {
+    if (lower && !(*lower < value || (lowerInclusive && *lower == value))) return false;
+    if (upper && !(value < *upper || (upperInclusive && value == *upper))) return false;
+    return true;
+}
+
+void ZoneMap::add(const Value& value) {
+    // NaN matches no predicate, and would poison the comparisons below.
+    if (const float* f = std::get_if<float>(&value); f && std::isnan(*f)) return;
+    distinctSketch |= 1ULL << (bloomHash(value) & 63);
+    if (empty) {
+        min = value;
+        max = value;
+        empty = false;
+    } else if (value < min) {
+        min = value;
+    } else if (max < value) {
+        max = value;
+    }
+}
+
+bool ZoneMap::mayOverlap(const ValueRange& range) const {
+    if (!range.lower && !range.upper) return true;
+    if (empty) return false;
+    if (range.lower && (max < *range.lower || (!range.lowerInclusive && max == *range.lower))) return false;
+    if (range.upper && (*range.upper < min || (!range.upperInclusive && min == *range.upper))) return false;
+    return true;
+}
+
+double ZoneMap::distinctEstimate() const {
+    const int zeros = 64 - std::popcount(distinctSketch);
+    return 64.0 * std::log(64.0 / std::max(zeros, 1));
+}
+
+namespace {
+bool holdsType(const Value& value, DataType type) {
+    return (type == DataType::Integer && std::holds_alternative<int>(value)) ||
+           (type == DataType::Float   && std::holds_alternative<float>(value)) ||
+           (type == DataType::String  && std::holds_alternative<std::string>(value));
+}
+
+void runParallel(ThreadPool* pool, std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (pool) {
+        pool->parallelFor(count, fn);
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) fn(i);
+}
+
+template<typename Key, typename KeyOf>
+void buildIndex(BPlusTree<Key, std::size_t>& index, const std::vector<std::shared_ptr<RowSegment>>& segments,
+                std::size_t rowCount, const std::string& column, ThreadPool* pool, KeyOf keyOf) {
+    std::vector<std::pair<Key, std::size_t>> pairs(rowCount);
+    runParallel(pool, segments.size(), [&](std::size_t s) {
+        const auto& rows = segments[s]->rows;
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            const std::size_t row = s * Table::kSegmentRows + i;
+            pairs[row] = {std::get<Key>(keyOf(rows[i])), row};
+        }
+    });
+    const auto byKey = [](const auto& a, const auto& b) { return a.first < b.first; };
+    parallelSort(pool, pairs.begin(), pairs.end(), byKey);
+    const auto dup = std::adjacent_find(pairs.begin(), pairs.end(),
+                                        [](const auto& a, const auto& b) { return a.first == b.first; });
+    if (dup != pairs.end())
+        throw std::runtime_error("Duplicate key for column: " + column);
+    index.bulkLoad(pairs);
+}
+}
 
 Table::Table(TableSchema schema)
     : tableSchema(std::move(schema))
 {
+    if (tableSchema.engine() == TableEngine::Lsm) {
+        const auto& cols = tableSchema.getColumns();
+        const auto& key = tableSchema.primaryKey();
+        if (key.size() > 1)
+            throw std::runtime_error("LSM tables take a single key column.");
+        const std::string keyName = !key.empty() ? key.front() : cols.empty() ? "" : cols.front().name;
+        auto keyCol = std::find_if(cols.begin(), cols.end(), [&](const Column& c) { return c.name == keyName; });
+        if (keyCol == cols.end() || keyCol->type == DataType::Float)
+            throw std::runtime_error("LSM tables need an int or string key column.");
+        indexedColumnName = keyName;
+        keyColumnNames = {keyName};
+        lsm = std::make_unique<LsmTree>(cols, indexedColumnName);
+        return;
+    }
     setupIndex();
+    // A single key column always gets a filter: absent-key probes (e.g. existence checks) skip the tree.
+    if (indexActive && !compositeKey) {
+        bloomColumns.push_back(indexedColumnName);
+        tableBlooms.emplace_back(kSegmentRows, bloomBits);
+        restoredBlooms.push_back(false);
+    }
 }
 
+Table::~Table() = default;
+
 void Table::setupIndex() {
-    // Index only on first column if int or string
+    // The declared primary key, else the first column if int or string
     const auto& cols = tableSchema.getColumns();
-    if (!cols.empty()) {
-        indexedColumnName = cols[0].name;
-        switch (cols[0].type) {
-        case DataType::Integer:
-            intIndex = std::make_unique<BPlusTree<int, Record>>();
-            indexActive = true;
-            break;
-        case DataType::String:
-            stringIndex = std::make_unique<BPlusTree<std::string, Record>>();
-            indexActive = true;
-            break;
-        default:
-            indexActive = false;
-        }
+    keyColumnNames = tableSchema.primaryKey();
+    if (keyColumnNames.empty() && !cols.empty() && cols[0].type != DataType::Float)
+        keyColumnNames.push_back(cols[0].name);
+    for (std::size_t k = 0; k < keyColumnNames.size(); ++k) {
+        const auto& name = keyColumnNames[k];
+        if (std::none_of(cols.begin(), cols.end(), [&](const Column& c) { return c.name == name; }))
+            throw std::runtime_error("Unknown key column: " + name);
+        if (std::find(keyColumnNames.begin(), keyColumnNames.begin() + k, name) != keyColumnNames.begin() + k)
+            throw std::runtime_error("Duplicate key column: " + name);
+    }
+    if (keyColumnNames.empty()) return;
+    indexActive = true;
+    if (keyColumnNames.size() > 1) {
+        compositeKey = true;
+        stringIndex = std::make_unique<BPlusTree<std::string, std::size_t>>();
+        return;
+    }
+    indexedColumnName = keyColumnNames.front();
+    const auto& keyCol = *std::find_if(cols.begin(), cols.end(), [&](const Column& c) { return c.name == indexedColumnName; });
+    switch (keyCol.type) {
+    case DataType::Integer:
+        intIndex = std::make_unique<BPlusTree<int, std::size_t>>();
+        break;
+    case DataType::String:
+        stringIndex = std::make_unique<BPlusTree<std::string, std::size_t>>();
+        break;
+    default:
+        throw std::runtime_error("A single key column must be int or string: " + indexedColumnName);
     }
 }
 
-void Table::insert(const Record& record) {
+Value Table::indexKey(const Record& record) const {
+    if (compositeKey) return encodeKey(record, keyColumnNames);
+    return record.at(indexedColumnName);
+}
+
+std::string Table::keyLabel() const {
+    std::string label;
+    for (const auto& name : keyColumnNames) label += (label.empty() ? "" : ",") + name;
+    return label;
+}
+
+void Table::validate(const Record& record) const {
     // Validate schema (simple check: keys and types)
     for (const auto& col : tableSchema.getColumns()) {
         auto it = record.find(col.name);
         if (it == record.end()) {
             throw std::runtime_error("Missing column: " + col.name);
         }
-        if ((col.type == DataType::Integer && !std::holds_alternative<int>(it->second)) ||
-            (col.type == DataType::Float   && !std::holds_alternative<float>(it->second)) ||
-            (col.type == DataType::String  && !std::holds_alternative<std::string>(it->second))) {
+        if (!holdsType(it->second, col.type)) {
             throw std::runtime_error("Type mismatch for column: " + col.name);
         }
     }
-    records.push_back(record);
-    // If indexed, update index
+}
+
+void Table::insert(const Record& record) {
+    if (lsm) {
+        // The memtable stores the encoded row, so there is nothing to move in.
+        validate(record);
+        lsm->put(record);
+        return;
+    }
+    insert(Record(record));
+}
+
+void Table::insert(Record&& record) {
+    validate(record);
+    if (lsm) {
+        // The tree synchronizes puts itself, so a put waiting on a flush does not hold up readers.
+        lsm->put(record);
+        return;
+    }
+    std::unique_lock lock(tableMutex);
+    // If indexed, the key must be unique: the index maps each key to exactly one row.
     if (indexActive) {
-        auto it = record.find(indexedColumnName);
-        if (it != record.end()) {
-            if (intIndex && std::holds_alternative<int>(it->second)) {
-                intIndex->insert(std::get<int>(it->second), record);
-            } else if (stringIndex && std::holds_alternative<std::string>(it->second)) {
-                stringIndex->insert(std::get<std::string>(it->second), record);
+        const Value key = indexKey(record);
+        // A Bloom negative proves the key is new without descending the tree.
+        const int bloom = compositeKey ? -1 : bloomIndex(indexedColumnName);
+        const bool maybePresent = bloom < 0 || tableBlooms[bloom].mayContain(bloomHash(key));
+        if (maybePresent && indexFind(key))
+            throw std::runtime_error("Duplicate key for column: " + keyLabel());
+        indexInsert(key, rowCount);
+    }
+    if (rowCount % kSegmentRows == 0) {
+        auto fresh = std::make_shared<RowSegment>();
+        fresh->rows.reserve(kSegmentRows);
+        fresh->epoch = snapshotEpoch.load(std::memory_order_relaxed);
+        fresh->blooms.assign(bloomColumns.size(), BlockedBloomFilter(kSegmentRows, bloomBits));
+        fresh->zones.resize(tableSchema.getColumns().size());
+        segments.push_back(std::move(fresh));
+    }
+    RowSegment& segment = writableSegment(rowCount);
+    bloomAdd(segment, record);
+    zoneAdd(segment, record);
+    segment.rows.push_back(std::move(record));
+    segment.tombstones.push_back(false);
+    rowCount++;
+    for (const auto& filter : tableBlooms) {
+        if (filter.keyCount() > filter.capacity()) {
+            rebuildBloomFilters(false);
+            break;
+        }
+    }
+}
+
+void Table::bulkLoad(std::vector<Record> rows, ThreadPool* pool, std::vector<std::vector<ZoneMap>> zones) {
+    if (lsm) {
+        // The memtable is already the fast path for a stream of puts.
+        for (const auto& record : rows) insert(record);
+        return;
+    }
+    std::unique_lock lock(tableMutex);
+    if (rowCount != 0)
+        throw std::runtime_error("Bulk load needs an empty table.");
+    const std::size_t segmentCount = (rows.size() + kSegmentRows - 1) / kSegmentRows;
+    const std::size_t columnCount = tableSchema.getColumns().size();
+    if (!zones.empty() && (zones.size() != segmentCount ||
+                           std::any_of(zones.begin(), zones.end(), [&](const auto& z) { return z.size() != columnCount; })))
+        throw std::runtime_error("Zone maps do not match the rows.");
+    std::vector<std::shared_ptr<RowSegment>> fresh(segmentCount);
+    const auto epoch = snapshotEpoch.load(std::memory_order_relaxed);
+    runParallel(pool, segmentCount, [&](std::size_t s) {
+        const std::size_t begin = s * kSegmentRows;
+        const std::size_t end = std::min(rows.size(), begin + kSegmentRows);
+        auto segment = std::make_shared<RowSegment>();
+        segment->rows.reserve(kSegmentRows);
+        segment->epoch = epoch;
+        segment->blooms.assign(bloomColumns.size(), BlockedBloomFilter(kSegmentRows, bloomBits));
+        const bool computeZones = zones.empty();
+        if (computeZones) segment->zones.resize(columnCount);
+        else segment->zones = std::move(zones[s]);
+        for (std::size_t r = begin; r < end; ++r) {
+            validate(rows[r]);
+            for (std::size_t b = 0; b < bloomColumns.size(); ++b)
+                segment->blooms[b].add(bloomHash(rows[r].at(bloomColumns[b])));
+            if (computeZones) zoneAdd(*segment, rows[r]);
+            segment->rows.push_back(std::move(rows[r]));
+        }
+        segment->tombstones.assign(end - begin, false);
+        fresh[s] = std::move(segment);
+    });
+    segments = std::move(fresh);
+    rowCount = rows.size();
+    heapGeneration++;
+    try {
+        rebuildIndex(pool);
+    } catch (...) {
+        segments.clear();
+        rowCount = 0;
+        rebuildIndex(nullptr);
+        rebuildBloomFilters(false);
+        throw;
+    }
+    // Table-level filters, one column per task; a restored filter already covers these rows.
+    runParallel(pool, bloomColumns.size(), [&](std::size_t b) {
+        if (restoredBlooms[b]) {
+            tableBlooms[b].setKeyCount(rowCount);
+            return;
+        }
+        for (const auto& segment : segments) {
+            for (const auto& record : segment->rows)
+                tableBlooms[b].add(bloomHash(record.at(bloomColumns[b])));
+        }
+    });
+    if (std::any_of(tableBlooms.begin(), tableBlooms.end(),
+                    [](const BlockedBloomFilter& f) { return f.keyCount() > f.capacity(); }))
+        rebuildBloomFilters(false);
+    restoredBlooms.assign(bloomColumns.size(), false);
+}
+
+std::vector<Record> Table::getRecords() const {
+    std::vector<Record> out;
+    std::shared_lock lock(tableMutex);
+    if (lsm) {
+        forEachLsmRecord([&](const Record& record) { out.push_back(record); return true; });
+        return out;
+    }
+    out.reserve(rowCount - deadRows);
+    for (const auto& segment : segments) {
+        for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+            if (!segment->tombstones[i]) out.push_back(segment->rows[i]);
+        }
+    }
+    return out;
+}
+
+TableSnapshot Table::snapshot() const {
+    return snapshot(lockShared());
+}
+
+std::shared_lock<std::shared_mutex> Table::lockShared() const {
+    return std::shared_lock(tableMutex);
+}
+
+TableSnapshot Table::snapshot(const std::shared_lock<std::shared_mutex>& held) const {
+    if (held.mutex() != &tableMutex || !held.owns_lock())
+        throw std::logic_error("Table::snapshot requires this table's shared lock.");
+    if (lsm) {
+        auto view = lsm->view();
+        const auto entries = view->entryCount();
+        return TableSnapshot(tableSchema, {}, entries, {}, bloomBits, std::move(view));
+    }
+    // Freeze every current segment; writers clone before their next in-place change.
+    snapshotEpoch.fetch_add(1, std::memory_order_relaxed);
+    return TableSnapshot(tableSchema, {segments.begin(), segments.end()}, rowCount - deadRows, bloomColumns, bloomBits);
+}
+
+std::optional<Record> Table::findByKey(const Value& key) const {
+    if (compositeKey)
+        throw std::runtime_error("Expected " + std::to_string(keyColumnNames.size()) + " key value(s) for " + keyLabel());
+    if (!indexedColumnName.empty()) return findFirst(indexedColumnName, key);
+    // Unkeyed (float first column): scan the first column, as before keys could be declared.
+    const auto& cols = tableSchema.getColumns();
+    if (cols.empty()) return std::nullopt;
+    return findFirst(cols.front().name, key);
+}
+
+std::optional<Record> Table::findByKey(const std::vector<Value>& key) const {
+    if (key.size() != keyColumnNames.size())
+        throw std::runtime_error("Expected " + std::to_string(keyColumnNames.size()) + " key value(s) for " + keyLabel());
+    if (!compositeKey) return findByKey(key.front());
+    const auto& cols = tableSchema.getColumns();
+    for (std::size_t k = 0; k < key.size(); ++k) {
+        const auto& col = *std::find_if(cols.begin(), cols.end(), [&](const Column& c) { return c.name == keyColumnNames[k]; });
+        if (!holdsType(key[k], col.type))
+            throw std::runtime_error("Type mismatch for key column: " + col.name);
+    }
+    std::shared_lock lock(tableMutex);
+    if (auto row = indexFind(encodeKey(key))) return rowAt(*row);
+    return std::nullopt;
+}
+
+std::optional<Record> Table::findFirst(const std::string& column, const Value& value) const {
+    std::shared_lock lock(tableMutex);
+    if (lsm) {
+        if (column == indexedColumnName) return lsm->get(value);
+        std::optional<Record> found;
+        forEachLsmRecord([&](const Record& record) {
+            auto it = record.find(column);
+            if (it != record.end() && it->second == value) found = record;
+            return !found;
+        });
+        return found;
+    }
+    auto rows = matchingRows(column, value);
+    if (rows.empty()) return std::nullopt;
+    return rowAt(rows.front());
+}
+
+std::size_t Table::scanRange(const std::string& column, const ValueRange& range,
+                             const std::function<bool(const Record&)>& fn) const {
+    const int c = columnIndex(column);
+    if (c < 0) throw std::runtime_error("Unknown column: " + column);
+    const DataType type = tableSchema.getColumns()[c].type;
+    if ((range.lower && !holdsType(*range.lower, type)) || (range.upper && !holdsType(*range.upper, type)))
+        throw std::runtime_error("Type mismatch for column: " + column);
+    std::shared_lock lock(tableMutex);
+    std::size_t visited = 0;
+    if (lsm) {
+        // Key ranges seek into the runs and stop past the upper bound; other columns are filtered.
+        const bool keyRange = column == indexedColumnName;
+        lsm->scan(keyRange ? range.lower : std::nullopt, std::nullopt, [&](const Record& record) {
+            const Value& value = record.at(column);
+            if (!range.contains(value)) return !(keyRange && range.upper && *range.upper < value);
+            visited++;
+            return fn(record);
+        });
+        return visited;
+    }
+    for (const auto& segment : segments) {
+        if (!segment->zones[c].mayOverlap(range)) {
+            zoneBlocksSkipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        zoneBlocksScanned.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+            if (segment->tombstones[i] || !range.contains(segment->rows[i].at(column))) continue;
+            visited++;
+            if (!fn(segment->rows[i])) return visited;
+        }
+    }
+    return visited;
+}
+
+namespace {
+// One row to sort: the column value in its memcomparable encoding (KeyCodec.h), so every type
+// compares as bytes with a total order, and the row it came from.
+struct SortEntry {
+    std::string key;
+    std::uint64_t row;
+};
+
+// Orders by key in the requested direction, then by row so ties keep insertion order.
+struct SortEntryLess {
+    bool descending;
+    bool operator()(const SortEntry& a, const SortEntry& b) const { return before(a.key, a.row, b); }
+    [[nodiscard]] bool before(std::string_view key, std::uint64_t row, const SortEntry& b) const {
+        const int c = key.compare(b.key);
+        if (c != 0) return descending ? c > 0 : c < 0;
+        return row < b.row;
+    }
+};
+
+// A sort entry that carries its record (append_record encoding), for sources without stable row
+// ids: LSM rows are read once in key order, and their position in that order is the row.
+struct SortRow {
+    SortEntry entry;
+    std::string record;
+};
+
+// Memory an entry for 'value' accounts for against the sort budget.
+std::size_t sortEntryBytes(const Value& value) {
+    const auto* str = std::get_if<std::string>(&value);
+    return sizeof(SortEntry) + (str ? str->size() + 2 : 4);
+}
+
+// Scratch directory for spilled sort runs, removed with everything in it.
+struct SpillDirectory {
+    SpillDirectory() {
+        std::random_device rd;
+        std::ostringstream name;
+        name << "marinadb-sort-" << std::hex << rd() << rd();
+        path = std::filesystem::temp_directory_path() / name.str();
+        std::filesystem::create_directories(path);
+    }
+    ~SpillDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    std::filesystem::path path;
+};
+
+// Sorted run file: per entry a u32 key length, the key bytes and the u64 row; runs of SortRows
+// follow each entry with a u32 length and the record bytes.
+void writeSortEntry(std::ostream& out, const SortEntry& entry) {
+    write_uint32(out, static_cast<std::uint32_t>(entry.key.size()));
+    out.write(entry.key.data(), static_cast<std::streamsize>(entry.key.size()));
+    write_uint64(out, entry.row);
+}
+
+void writeSortRun(const std::filesystem::path& path, const std::vector<SortEntry>& entries) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    for (const auto& entry : entries) writeSortEntry(out, entry);
+    if (!out) throw std::runtime_error("Cannot write sort run: " + path.string());
+}
+
+void writeSortRun(const std::filesystem::path& path, const std::vector<SortRow>& rows) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    for (const auto& row : rows) {
+        writeSortEntry(out, row.entry);
+        write_uint32(out, static_cast<std::uint32_t>(row.record.size()));
+        out.write(row.record.data(), static_cast<std::streamsize>(row.record.size()));
+    }
+    if (!out) throw std::runtime_error("Cannot write sort run: " + path.string());
+}
+
+// Streams a run back one entry at a time through a private read buffer.
+class SortRunReader {
+public:
+    SortRunReader(const std::filesystem::path& path, std::size_t entries, bool withRecords = false)
+        : remaining(entries), records(withRecords), buffer(64 * 1024) {
+        in.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        in.open(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot open sort run: " + path.string());
+    }
+
+    // Loads the next entry into 'current' (and its record, for runs of SortRows); false once the run is exhausted.
+    bool next() {
+        if (remaining == 0) return false;
+        remaining--;
+        current.key.resize(read_uint32(in));
+        in.read(current.key.data(), static_cast<std::streamsize>(current.key.size()));
+        current.row = read_uint64(in);
+        if (records) {
+            record.resize(read_uint32(in));
+            in.read(record.data(), static_cast<std::streamsize>(record.size()));
+        }
+        if (!in) throw std::runtime_error("Corrupt sort run.");
+        return true;
+    }
+
+    SortEntry current;
+    std::string record;
+
+private:
+    std::size_t remaining;
+    bool records;
+    std::vector<char> buffer;
+    std::ifstream in;
+};
+
+// k-way merge of sorted runs: fn(reader) is called with the reader holding the next entry in order,
+// at most 'limit' times; fn returns false to stop.
+template<typename Fn>
+void mergeSortRuns(const std::vector<std::unique_ptr<SortRunReader>>& readers, const SortEntryLess& less,
+                   std::size_t limit, Fn&& fn) {
+    const auto after = [&](std::size_t a, std::size_t b) { return less(readers[b]->current, readers[a]->current); };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(after)> merge(after);
+    for (std::size_t r = 0; r < readers.size(); ++r) {
+        if (readers[r]->next()) merge.push(r);
+    }
+    for (std::size_t emitted = 0; emitted < limit && !merge.empty(); ++emitted) {
+        const std::size_t r = merge.top();
+        merge.pop();
+        if (!fn(*readers[r])) break;
+        if (readers[r]->next()) merge.push(r);
+    }
+}
+
+// Sorts the rows reported by visitPart(p, visit) for parts [0, parts) and passes rowAt(row) to fn in
+// order, at most 'limit' of them. visit(value, row) is called per live row; parts run concurrently.
+template<typename VisitPart, typename RowAt>
+OrderByPlan sortedScan(std::size_t parts, VisitPart visitPart, RowAt rowAt, SortOrder order, std::size_t limit,
+                       std::size_t budget, ThreadPool* pool, const std::function<bool(const Record&)>& fn) {
+    const SortEntryLess less{order == SortOrder::Descending};
+    const std::size_t workers = pool ? pool->concurrency() : 1;
+    const auto emit = [&](const std::vector<SortEntry>& sorted) {
+        for (std::size_t i = 0; i < sorted.size() && i < limit; ++i) {
+            if (!fn(rowAt(sorted[i].row))) break;
+        }
+    };
+
+    // Top-N: each worker keeps a max-heap of its best 'limit' entries, so the worst one is evicted
+    // in O(log limit); the survivors of all workers are sorted at the end.
+    if (limit == 0) return OrderByPlan::TopN;
+    if (limit != Table::kNoLimit && limit <= budget / (sizeof(SortEntry) * workers)) {
+        std::vector<std::vector<SortEntry>> heaps(workers);
+        runParallel(pool, workers, [&](std::size_t w) {
+            auto& heap = heaps[w];
+            std::string key;
+            for (std::size_t p = w; p < parts; p += workers) {
+                visitPart(p, [&](const Value& value, std::uint64_t row) {
+                    key.clear();
+                    appendKeyPart(key, value);
+                    if (heap.size() < limit) {
+                        heap.push_back({key, row});
+                        std::push_heap(heap.begin(), heap.end(), less);
+                    } else if (less.before(key, row, heap.front())) {
+                        std::pop_heap(heap.begin(), heap.end(), less);
+                        heap.back().key.assign(key);
+                        heap.back().row = row;
+                        std::push_heap(heap.begin(), heap.end(), less);
+                    }
+                });
+            }
+        });
+        std::vector<SortEntry> best;
+        for (auto& heap : heaps) std::move(heap.begin(), heap.end(), std::back_inserter(best));
+        std::sort(best.begin(), best.end(), less);
+        emit(best);
+        return OrderByPlan::TopN;
+    }
+
+    // Size every part first: that decides between one in-memory sort and spilled runs.
+    std::vector<std::size_t> counts(parts), bytes(parts);
+    runParallel(pool, parts, [&](std::size_t p) {
+        visitPart(p, [&](const Value& value, std::uint64_t) {
+            counts[p]++;
+            bytes[p] += sortEntryBytes(value);
+        });
+    });
+    if (std::accumulate(bytes.begin(), bytes.end(), std::size_t{0}) <= budget) {
+        std::vector<std::size_t> offsets(parts + 1);
+        std::partial_sum(counts.begin(), counts.end(), offsets.begin() + 1);
+        std::vector<SortEntry> entries(offsets.back());
+        runParallel(pool, parts, [&](std::size_t p) {
+            auto out = entries.begin() + static_cast<std::ptrdiff_t>(offsets[p]);
+            visitPart(p, [&](const Value& value, std::uint64_t row) {
+                appendKeyPart(out->key, value);
+                out->row = row;
+                ++out;
+            });
+        });
+        parallelSort(pool, entries.begin(), entries.end(), less);
+        emit(entries);
+        return OrderByPlan::MemorySort;
+    }
+
+    // External merge sort: consecutive parts are grouped into runs of at most budget / workers bytes,
+    // so the runs being sorted at once stay within the budget. Only the first 'limit' entries of a
+    // run can reach the output, so runs are cut there before they are written.
+    const std::size_t runBudget = std::max<std::size_t>(1, budget / workers);
+    std::vector<std::size_t> runStarts{0};
+    for (std::size_t p = 0, size = 0; p < parts; ++p) {
+        if (size > 0 && size + bytes[p] > runBudget) {
+            runStarts.push_back(p);
+            size = 0;
+        }
+        size += bytes[p];
+    }
+    runStarts.push_back(parts);
+    const std::size_t runs = runStarts.size() - 1;
+    const SpillDirectory spill;
+    const auto runPath = [&](std::size_t r) { return spill.path / ("run-" + std::to_string(r)); };
+    std::vector<std::size_t> runEntries(runs);
+    runParallel(pool, runs, [&](std::size_t r) {
+        std::vector<SortEntry> entries;
+        entries.reserve(std::accumulate(counts.begin() + static_cast<std::ptrdiff_t>(runStarts[r]),
+                                        counts.begin() + static_cast<std::ptrdiff_t>(runStarts[r + 1]), std::size_t{0}));
+        for (std::size_t p = runStarts[r]; p < runStarts[r + 1]; ++p) {
+            visitPart(p, [&](const Value& value, std::uint64_t row) {
+                entries.push_back({{}, row});
+                appendKeyPart(entries.back().key, value);
+            });
+        }
+        std::sort(entries.begin(), entries.end(), less);
+        if (entries.size() > limit) entries.resize(limit);
+        runEntries[r] = entries.size();
+        writeSortRun(runPath(r), entries);
+    });
+
+    std::vector<std::unique_ptr<SortRunReader>> readers;
+    readers.reserve(runs);
+    for (std::size_t r = 0; r < runs; ++r) readers.push_back(std::make_unique<SortRunReader>(runPath(r), runEntries[r]));
+    mergeSortRuns(readers, less, limit, [&](const SortRunReader& reader) { return fn(rowAt(reader.current.row)); });
+    return OrderByPlan::ExternalSort;
+}
+
+// sortedScan for a source that can only be read once, in order: scan(visit) calls visit(record)
+// per live record. The sort entries carry the records, so nothing has to be fetched back; entries
+// are buffered up to 'budget' bytes, and a source larger than that is spilled in sorted runs.
+template<typename Scan>
+OrderByPlan sortedStream(Scan scan, const std::vector<Column>& columns, const std::string& column, SortOrder order,
+                         std::size_t limit, std::size_t budget, ThreadPool* pool,
+                         const std::function<bool(const Record&)>& fn) {
+    const SortEntryLess less{order == SortOrder::Descending};
+    const auto rowLess = [&](const SortRow& a, const SortRow& b) { return less(a.entry, b.entry); };
+    const auto emit = [&](const std::vector<SortRow>& sorted) {
+        for (std::size_t i = 0; i < sorted.size() && i < limit; ++i) {
+            if (!fn(parse_record(sorted[i].record, columns))) break;
+        }
+    };
+    if (limit == 0) return OrderByPlan::TopN;
+
+    std::uint64_t row = 0;
+    std::string key;
+    if (limit != Table::kNoLimit && limit <= budget / sizeof(SortRow)) {
+        // Top-N: a max-heap of the best 'limit' rows; a row is only encoded once it gets in.
+        std::vector<SortRow> heap;
+        scan([&](const Record& record) {
+            key.clear();
+            appendKeyPart(key, record.at(column));
+            if (heap.size() < limit) {
+                heap.push_back({{key, row}, {}});
+            } else if (less.before(key, row, heap.front().entry)) {
+                std::pop_heap(heap.begin(), heap.end(), rowLess);
+                heap.back().entry.key.assign(key);
+                heap.back().entry.row = row;
+                heap.back().record.clear();
+            } else {
+                row++;
+                return true;
             }
+            append_record(heap.back().record, columns, record);
+            std::push_heap(heap.begin(), heap.end(), rowLess);
+            row++;
+            return true;
+        });
+        std::sort(heap.begin(), heap.end(), rowLess);
+        emit(heap);
+        return OrderByPlan::TopN;
+    }
+
+    // Buffer rows until the budget is used, then sort them into a run; a source that fits is sorted in memory.
+    std::optional<SpillDirectory> spill;
+    std::vector<std::size_t> runEntries;
+    const auto runPath = [&](std::size_t r) { return spill->path / ("run-" + std::to_string(r)); };
+    std::vector<SortRow> rows;
+    std::size_t bytes = 0;
+    const auto spillRun = [&] {
+        if (!spill) spill.emplace();
+        parallelSort(pool, rows.begin(), rows.end(), rowLess);
+        if (rows.size() > limit) rows.resize(limit);
+        writeSortRun(runPath(runEntries.size()), rows);
+        runEntries.push_back(rows.size());
+        rows.clear();
+        bytes = 0;
+    };
+    scan([&](const Record& record) {
+        const Value& value = record.at(column);
+        rows.push_back({{{}, row++}, {}});
+        appendKeyPart(rows.back().entry.key, value);
+        append_record(rows.back().record, columns, record);
+        bytes += sortEntryBytes(value) + sizeof(std::string) + rows.back().record.size();
+        if (bytes > budget && rows.size() >= Table::kSegmentRows) spillRun();     // runs of at least a segment, as for the heap
+        return true;
+    });
+    if (!spill) {
+        parallelSort(pool, rows.begin(), rows.end(), rowLess);
+        emit(rows);
+        return OrderByPlan::MemorySort;
+    }
+    if (!rows.empty()) spillRun();
+    std::vector<SortRow>().swap(rows);
+
+    std::vector<std::unique_ptr<SortRunReader>> readers;
+    readers.reserve(runEntries.size());
+    for (std::size_t r = 0; r < runEntries.size(); ++r)
+        readers.push_back(std::make_unique<SortRunReader>(runPath(r), runEntries[r], true));
+    mergeSortRuns(readers, less, limit, [&](const SortRunReader& reader) {
+        return fn(parse_record(reader.record, columns));
+    });
+    return OrderByPlan::ExternalSort;
+}
+}
+
+OrderByPlan Table::orderBy(const std::string& column, SortOrder order, std::size_t limit,
+                           const std::function<bool(const Record&)>& fn, ThreadPool* pool) const {
+    const auto& cols = tableSchema.getColumns();
+    if (std::none_of(cols.begin(), cols.end(), [&](const Column& c) { return c.name == column; }))
+        throw std::runtime_error("Unknown column: " + column);
+    const bool descending = order == SortOrder::Descending;
+    std::shared_lock lock(tableMutex);
+
+    // Already in key order: stream it and stop after 'limit' rows.
+    std::size_t emitted = 0;
+    const auto take = [&](const Record& record) { return emitted++ < limit && fn(record); };
+    if (lsm && column == indexedColumnName && !descending) {
+        forEachLsmRecord(take);
+        return OrderByPlan::IndexScan;
+    }
+    // A composite key sorts by its first column first, so its index serves that column too.
+    if (indexActive && column == keyColumnNames.front()) {
+        const auto visit = [&](const auto&, std::size_t row) { return take(rowAt(row)); };
+        if (intIndex) intIndex->scan(descending, visit);
+        else stringIndex->scan(descending, visit);
+        return OrderByPlan::IndexScan;
+    }
+
+    if (lsm) {
+        // LSM rows are merged out of the runs once (puts do not take the table lock, so a second
+        // pass could see different rows) and sorted with their records.
+        const auto scan = [&](const std::function<bool(const Record&)>& visit) { forEachLsmRecord(visit); };
+        return sortedStream(scan, cols, column, order, limit, sortBudget, pool, fn);
+    }
+    const auto visitPart = [&](std::size_t s, const auto& visit) {
+        const RowSegment& segment = *segments[s];
+        for (std::size_t i = 0; i < segment.rows.size(); ++i) {
+            if (!segment.tombstones[i]) visit(segment.rows[i].at(column), s * kSegmentRows + i);
+        }
+    };
+    const auto heapRowAt = [&](std::uint64_t row) -> const Record& { return rowAt(row); };
+    return sortedScan(segments.size(), visitPart, heapRowAt, order, limit, sortBudget, pool, fn);
+}
+
+std::size_t Table::erase(const std::string& column, const Value& value) {
+    std::unique_lock lock(tableMutex);
+    if (lsm) {
+        // A delete is a tombstone write per matching key; the data goes away in compaction.
+        auto keys = lsmMatchingKeys(column, value);
+        for (const auto& key : keys) lsm->remove(key);
+        return keys.size();
+    }
+    auto rows = matchingRows(column, value);
+    for (auto row : rows) {
+        if (indexActive) indexErase(indexKey(rowAt(row)));
+        writableSegment(row).tombstones[row % kSegmentRows] = true;
+        deadRows++;
+    }
+    if (!rows.empty()) maybeScheduleCompaction();
+    return rows.size();
+}
+
+std::size_t Table::update(const std::string& column, const Value& value, const Record& changes) {
+    for (const auto& [name, val] : changes) {
+        auto& cols = tableSchema.getColumns();
+        if (std::none_of(cols.begin(), cols.end(), [&](const Column& c) { return c.name == name; }))
+            throw std::runtime_error("Unknown column: " + name);
+    }
+    std::unique_lock lock(tableMutex);
+    if (lsm) return updateLsm(column, value, changes);
+    auto rows = matchingRows(column, value);
+    // Build and validate every new row before touching the heap, so a failure leaves the table intact.
+    std::vector<Record> updated;
+    updated.reserve(rows.size());
+    for (auto row : rows) {
+        Record rec = rowAt(row);
+        for (const auto& [name, val] : changes) rec[name] = val;
+        validate(rec);
+        updated.push_back(std::move(rec));
+    }
+    const bool keyChange = indexActive && std::any_of(keyColumnNames.begin(), keyColumnNames.end(),
+                                                      [&](const std::string& name) { return changes.contains(name); });
+    std::vector<Value> newKeys;
+    if (keyChange) {
+        // The new keys must be distinct and free, except for keys the updated rows give up.
+        const std::unordered_set<std::size_t> updating(rows.begin(), rows.end());
+        std::set<Value> seen;
+        for (const auto& rec : updated) {
+            newKeys.push_back(indexKey(rec));
+            if (!seen.insert(newKeys.back()).second)
+                throw std::runtime_error("Update would duplicate key for column: " + keyLabel());
+            auto existing = indexFind(newKeys.back());
+            if (existing && !updating.contains(*existing))
+                throw std::runtime_error("Duplicate key for column: " + keyLabel());
         }
+        for (auto row : rows) indexErase(indexKey(rowAt(row)));
+    }
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        std::size_t row = rows[i];
+        if (keyChange) indexInsert(newKeys[i], row);
+        RowSegment& segment = writableSegment(row);
+        bloomAdd(segment, updated[i]);
+        zoneAdd(segment, updated[i]);
+        segment.rows[row % kSegmentRows] = std::move(updated[i]);
     }
+    return rows.size();
 }
 
-const std::vector<Record>& Table::getRecords() const {
-    return records;
+void Table::compact() {
+    // The LSM tree synchronizes itself, and merging runs does not change the visible rows.
+    if (lsm) {
+        lsm->compactAll();
+        return;
+    }
+    std::unique_lock lock(tableMutex);
+    compactLocked();
 }
 
-const Record* Table::findByKey(const Value& key) const {
-    if (indexActive) {
-        // Find using index, then find pointer in records for safety
-        if (intIndex && std::holds_alternative<int>(key)) {
-            auto result = intIndex->find(std::get<int>(key));
-            if (result) {
-                // Search records for address matching value
-                for (const auto& record : records) {
-                    auto it = record.find(indexedColumnName);
-                    if (it != record.end() && it->second == key)
-                        return &record;
-                }
+std::size_t Table::liveRowCount() const {
+    std::shared_lock lock(tableMutex);
+    if (lsm) {
+        std::size_t live = 0;
+        forEachLsmRecord([&](const Record&) { live++; return true; });
+        return live;
+    }
+    return rowCount - deadRows;
+}
+
+std::size_t Table::tombstoneCount() const {
+    std::shared_lock lock(tableMutex);
+    return deadRows;
+}
+
+void Table::addBloomFilter(const std::string& column) {
+    const auto& cols = tableSchema.getColumns();
+    if (std::none_of(cols.begin(), cols.end(), [&](const Column& c) { return c.name == column; }))
+        throw std::runtime_error("Unknown column: " + column);
+    if (lsm)
+        throw std::runtime_error("LSM tables keep their own per-run key filters.");
+    std::unique_lock lock(tableMutex);
+    if (bloomIndex(column) >= 0) return;
+    bloomColumns.push_back(column);
+    rebuildBloomFilters(true);
+}
+
+void Table::setBloomBitsPerKey(std::size_t bitsPerKey) {
+    if (bitsPerKey == 0 || bitsPerKey > 64)
+        throw std::runtime_error("Bloom bits per key must be between 1 and 64.");
+    std::unique_lock lock(tableMutex);
+    bloomBits = bitsPerKey;
+    rebuildBloomFilters(true);
+}
+
+std::size_t Table::bloomBitsPerKey() const {
+    std::shared_lock lock(tableMutex);
+    return bloomBits;
+}
+
+std::vector<std::string> Table::bloomFilterColumns() const {
+    std::shared_lock lock(tableMutex);
+    return bloomColumns;
+}
+
+void Table::restoreBloomFilter(const std::string& column, BlockedBloomFilter filter) {
+    std::unique_lock lock(tableMutex);
+    const int bloom = bloomIndex(column);
+    if (bloom < 0)
+        throw std::runtime_error("No Bloom filter on column: " + column);
+    tableBlooms[bloom] = std::move(filter);
+    restoredBlooms[bloom] = true;
+}
+
+std::vector<ZoneMap> Table::zoneMaps(const std::string& column) const {
+    const int c = columnIndex(column);
+    if (c < 0) throw std::runtime_error("Unknown column: " + column);
+    std::shared_lock lock(tableMutex);
+    std::vector<ZoneMap> out;
+    out.reserve(segments.size());
+    for (const auto& segment : segments) out.push_back(segment->zones[c]);
+    return out;
+}
+
+ZoneMapStats Table::zoneMapStats() const {
+    return {zoneBlocksScanned.load(std::memory_order_relaxed), zoneBlocksSkipped.load(std::memory_order_relaxed)};
+}
+
+BloomStats Table::bloomStats() const {
+    BloomStats stats;
+    stats.probes = bloomProbes.load(std::memory_order_relaxed);
+    stats.negatives = bloomNegatives.load(std::memory_order_relaxed);
+    stats.falsePositives = bloomFalsePositives.load(std::memory_order_relaxed);
+    if (lsm) {
+        // Run filters count per run probed; a probe that passes is not tracked as a false positive.
+        const auto runs = lsm->stats();
+        stats.probes += runs.bloomProbes;
+        stats.negatives += runs.bloomNegatives;
+    }
+    return stats;
+}
+
+std::optional<std::size_t> Table::indexFind(const Value& key) const {
+    if (intIndex && std::holds_alternative<int>(key))
+        return intIndex->find(std::get<int>(key));
+    if (stringIndex && std::holds_alternative<std::string>(key))
+        return stringIndex->find(std::get<std::string>(key));
+    return std::nullopt;
+}
+
+void Table::indexInsert(const Value& key, std::size_t row) {
+    if (intIndex && std::holds_alternative<int>(key))
+        intIndex->insert(std::get<int>(key), row);
+    else if (stringIndex && std::holds_alternative<std::string>(key))
+        stringIndex->insert(std::get<std::string>(key), row);
+}
+
+void Table::indexErase(const Value& key) {
+    if (intIndex && std::holds_alternative<int>(key))
+        intIndex->erase(std::get<int>(key));
+    else if (stringIndex && std::holds_alternative<std::string>(key))
+        stringIndex->erase(std::get<std::string>(key));
+}
+
+std::vector<std::size_t> Table::matchingRows(const std::string& column, const Value& value) const {
+    std::vector<std::size_t> rows;
+    const int bloom = bloomIndex(column);
+    std::uint64_t hash = 0;
+    if (bloom >= 0) {
+        hash = bloomHash(value);
+        bloomProbes.fetch_add(1, std::memory_order_relaxed);
+        if (!tableBlooms[bloom].mayContain(hash)) {
+            bloomNegatives.fetch_add(1, std::memory_order_relaxed);
+            return rows;
+        }
+    }
+    if (indexActive && column == indexedColumnName) {
+        // Keys are unique and the index only holds live rows.
+        if (auto row = indexFind(value)) rows.push_back(*row);
+    } else {
+        // Fall back to full scan if not indexed or not the key column, skipping segments the zone map
+        // or the filter rules out
+        const int zone = columnIndex(column);
+        const ValueRange point{value, value};
+        for (std::size_t s = 0; s < segments.size(); ++s) {
+            const RowSegment& segment = *segments[s];
+            if (zone >= 0 && !segment.zones[zone].mayOverlap(point)) {
+                zoneBlocksSkipped.fetch_add(1, std::memory_order_relaxed);
+                continue;
             }
-        } else if (stringIndex && std::holds_alternative<std::string>(key)) {
-            auto result = stringIndex->find(std::get<std::string>(key));
-            if (result) {
-                for (const auto& record : records) {
-                    auto it = record.find(indexedColumnName);
-                    if (it != record.end() && it->second == key)
-                        return &record;
-                }
+            if (bloom >= 0 && !segment.blooms[bloom].mayContain(hash)) continue;
+            zoneBlocksScanned.fetch_add(1, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < segment.rows.size(); ++i) {
+                if (segment.tombstones[i]) continue;
+                auto it = segment.rows[i].find(column);
+                if (it != segment.rows[i].end() && it->second == value)
+                    rows.push_back(s * kSegmentRows + i);
             }
         }
     }
-    // Fall back to full scan if not indexed or type mismatch
-    for (const auto& record : records) {
-        auto it = record.find(indexedColumnName);
-        if (it != record.end() && key == it->second)
-            return &record;
+    if (bloom >= 0 && rows.empty())
+        bloomFalsePositives.fetch_add(1, std::memory_order_relaxed);
+    return rows;
+}
+
+int Table::bloomIndex(const std::string& column) const {
+    for (std::size_t i = 0; i < bloomColumns.size(); ++i) {
+        if (bloomColumns[i] == column) return static_cast<int>(i);
     }
-    return nullptr;
+    return -1;
+}
+
+void Table::bloomAdd(RowSegment& segment, const Record& record) {
+    for (std::size_t i = 0; i < bloomColumns.size(); ++i) {
+        const auto hash = bloomHash(record.at(bloomColumns[i]));
+        segment.blooms[i].add(hash);
+        tableBlooms[i].add(hash);
+    }
+}
+
+void Table::zoneAdd(RowSegment& segment, const Record& record) const {
+    const auto& cols = tableSchema.getColumns();
+    for (std::size_t c = 0; c < cols.size(); ++c) segment.zones[c].add(record.at(cols[c].name));
+}
+
+int Table::columnIndex(const std::string& column) const {
+    const auto& cols = tableSchema.getColumns();
+    for (std::size_t c = 0; c < cols.size(); ++c) {
+        if (cols[c].name == column) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+void Table::rebuildBloomFilters(bool includeSegments) {
+    // Twice the live rows, so a growing table rebuilds O(log N) times in total.
+    const std::size_t capacity = std::max(kSegmentRows, 2 * (rowCount - deadRows));
+    tableBlooms.assign(bloomColumns.size(), BlockedBloomFilter(capacity, bloomBits));
+    restoredBlooms.assign(bloomColumns.size(), false);
+    for (std::size_t s = 0; s < segments.size(); ++s) {
+        const RowSegment* segment = segments[s].get();
+        RowSegment* writable = nullptr;
+        if (includeSegments) {
+            writable = &writableSegment(s * kSegmentRows);
+            writable->blooms.assign(bloomColumns.size(), BlockedBloomFilter(kSegmentRows, bloomBits));
+            segment = writable;
+        }
+        for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+            if (segment->tombstones[i]) continue;
+            for (std::size_t b = 0; b < bloomColumns.size(); ++b) {
+                const auto hash = bloomHash(segment->rows[i].at(bloomColumns[b]));
+                tableBlooms[b].add(hash);
+                if (writable) writable->blooms[b].add(hash);
+            }
+        }
+    }
+}
+
+void Table::rebuildIndex(ThreadPool* pool) {
+    const auto keyOf = [this](const Record& record) { return indexKey(record); };
+    if (intIndex) buildIndex(*intIndex, segments, rowCount, keyLabel(), pool, keyOf);
+    if (stringIndex) buildIndex(*stringIndex, segments, rowCount, keyLabel(), pool, keyOf);
+}
+
+const Record& Table::rowAt(std::size_t row) const {
+    return segments[row / kSegmentRows]->rows[row % kSegmentRows];
+}
+
+bool Table::isDead(std::size_t row) const {
+    return segments[row / kSegmentRows]->tombstones[row % kSegmentRows];
+}
+
+RowSegment& Table::writableSegment(std::size_t row) {
+    auto& segment = segments[row / kSegmentRows];
+    // A segment from before the latest snapshot may still be read by it (use_count() is not
+    // a synchronization point), so it is cloned once and the copy becomes writable.
+    const auto epoch = snapshotEpoch.load(std::memory_order_relaxed);
+    if (segment->epoch != epoch) {
+        segment = std::make_shared<RowSegment>(*segment);
+        segment->epoch = epoch;
+    }
+    return *segment;
+}
+
+// A packed copy of the heap built from frozen segments, and what it was built from.
+struct Table::CompactedHeap {
+    std::vector<std::shared_ptr<RowSegment>> source;
+    std::size_t sourceRows = 0;
+    std::uint64_t generation = 0;
+    std::vector<std::string> bloomColumns;
+    std::size_t bloomBits = 0;
+
+    std::vector<std::shared_ptr<RowSegment>> segments;
+    std::size_t rows = 0;
+    std::vector<std::size_t> firstRow;      // packed row id of each source segment's first live row
+    std::unique_ptr<BPlusTree<int, std::size_t>> intIndex;
+    std::unique_ptr<BPlusTree<std::string, std::size_t>> stringIndex;
+    std::vector<BlockedBloomFilter> tableBlooms;
+
+    // Appends a live row to the packed heap and its filters; returns its row id.
+    std::size_t append(const Table& table, const Record& record) {
+        if (rows % kSegmentRows == 0) {
+            auto segment = std::make_shared<RowSegment>();
+            segment->rows.reserve(kSegmentRows);
+            segment->blooms.assign(bloomColumns.size(), BlockedBloomFilter(kSegmentRows, bloomBits));
+            segment->zones.resize(table.tableSchema.getColumns().size());
+            segments.push_back(std::move(segment));
+        }
+        RowSegment& segment = *segments.back();
+        segment.rows.push_back(record);
+        segment.tombstones.push_back(false);
+        addToFilters(table, segment, record);
+        return rows++;
+    }
+
+    void addToFilters(const Table& table, RowSegment& segment, const Record& record) {
+        table.zoneAdd(segment, record);
+        for (std::size_t b = 0; b < bloomColumns.size(); ++b) {
+            const auto hash = bloomHash(record.at(bloomColumns[b]));
+            segment.blooms[b].add(hash);
+            if (!tableBlooms.empty()) tableBlooms[b].add(hash);
+        }
+    }
+};
+
+std::unique_ptr<Table::CompactedHeap> Table::captureCompaction() const {
+    auto heap = std::make_unique<CompactedHeap>();
+    heap->source.assign(segments.begin(), segments.end());
+    heap->sourceRows = rowCount;
+    heap->generation = heapGeneration;
+    heap->bloomColumns = bloomColumns;
+    heap->bloomBits = bloomBits;
+    if (intIndex) heap->intIndex = std::make_unique<BPlusTree<int, std::size_t>>();
+    if (stringIndex) heap->stringIndex = std::make_unique<BPlusTree<std::string, std::size_t>>();
+    // Freeze the captured segments: writers clone one before changing it, so the build can read
+    // them without the lock and installCompacted can tell which ones changed.
+    snapshotEpoch.fetch_add(1, std::memory_order_relaxed);
+    return heap;
+}
+
+void Table::buildCompacted(CompactedHeap& heap) const {
+    for (const auto& segment : heap.source) {
+        heap.firstRow.push_back(heap.rows);
+        for (std::size_t i = 0; i < segment->rows.size(); ++i) {
+            if (!segment->tombstones[i]) heap.append(*this, segment->rows[i]);
+        }
+    }
+    const auto keyOf = [this](const Record& record) { return indexKey(record); };
+    if (heap.intIndex) buildIndex(*heap.intIndex, heap.segments, heap.rows, keyLabel(), nullptr, keyOf);
+    if (heap.stringIndex) buildIndex(*heap.stringIndex, heap.segments, heap.rows, keyLabel(), nullptr, keyOf);
+    // Twice the live rows, as in rebuildBloomFilters; deleted keys drop out of the filters here.
+    heap.tableBlooms.assign(heap.bloomColumns.size(),
+                            BlockedBloomFilter(std::max(kSegmentRows, 2 * heap.rows), heap.bloomBits));
+    for (const auto& segment : heap.segments) {
+        for (const auto& record : segment->rows) {
+            for (std::size_t b = 0; b < heap.bloomColumns.size(); ++b)
+                heap.tableBlooms[b].add(bloomHash(record.at(heap.bloomColumns[b])));
+        }
+    }
+}
+
+void Table::installCompacted(CompactedHeap& heap) {
+    // A synchronous compaction or bulk load replaced the heap meanwhile; its row ids no longer apply.
+    if (heap.generation != heapGeneration) return;
+
+    // Carry over the writes made since the capture. A segment that was written has been cloned, so
+    // only those are compared row by row; rows past sourceRows were inserted since.
+    std::vector<Value> staleKeys;
+    std::vector<std::pair<Value, std::size_t>> freshKeys;
+    std::size_t dead = 0;
+    for (std::size_t s = 0; s < heap.source.size(); ++s) {
+        if (segments[s] == heap.source[s]) continue;
+        const RowSegment& before = *heap.source[s];
+        const RowSegment& now = *segments[s];
+        std::size_t row = heap.firstRow[s];
+        for (std::size_t i = 0; i < before.rows.size(); ++i) {
+            if (before.tombstones[i]) continue;
+            RowSegment& out = *heap.segments[row / kSegmentRows];
+            const std::size_t slot = row++ % kSegmentRows;
+            const bool keyChanged = indexActive && (now.tombstones[i] || indexKey(now.rows[i]) != indexKey(before.rows[i]));
+            if (keyChanged) staleKeys.push_back(indexKey(before.rows[i]));
+            if (now.tombstones[i]) {
+                out.tombstones[slot] = true;
+                dead++;
+                continue;
+            }
+            out.rows[slot] = now.rows[i];
+            heap.addToFilters(*this, out, out.rows[slot]);
+            if (keyChanged) freshKeys.emplace_back(indexKey(out.rows[slot]), row - 1);
+        }
+    }
+    for (std::size_t r = heap.sourceRows; r < rowCount; ++r) {
+        if (isDead(r)) continue;
+        const std::size_t row = heap.append(*this, rowAt(r));
+        if (indexActive) freshKeys.emplace_back(indexKey(rowAt(r)), row);
+    }
+
+    const auto epoch = snapshotEpoch.load(std::memory_order_relaxed);
+    for (auto& segment : heap.segments) segment->epoch = epoch;
+    segments = std::move(heap.segments);
+    rowCount = heap.rows;
+    deadRows = dead;
+    intIndex = std::move(heap.intIndex);
+    stringIndex = std::move(heap.stringIndex);
+    for (const auto& key : staleKeys) indexErase(key);
+    for (const auto& [key, row] : freshKeys) indexInsert(key, row);
+    if (heap.bloomColumns != bloomColumns || heap.bloomBits != bloomBits) {
+        rebuildBloomFilters(true);      // the filters were reconfigured during the build
+    } else {
+        tableBlooms = std::move(heap.tableBlooms);
+        restoredBlooms.assign(bloomColumns.size(), false);
+        if (std::any_of(tableBlooms.begin(), tableBlooms.end(),
+                        [](const BlockedBloomFilter& f) { return f.keyCount() > f.capacity(); }))
+            rebuildBloomFilters(false);
+    }
+    heapGeneration++;
+}
+
+void Table::compactLocked() {
+    if (deadRows == 0) return;
+    // Snapshots keep the old segments alive until they are released.
+    auto heap = captureCompaction();
+    buildCompacted(*heap);
+    installCompacted(*heap);
+}
+
+void Table::maybeScheduleCompaction() {
+    if (compactionScheduled || deadRows < kMinCompactionRows) return;
+    if (static_cast<double>(deadRows) < compactionRatio * static_cast<double>(rowCount)) return;
+    compactionScheduled = true;
+    // The previous compactor cleared compactionScheduled as its last locked step, so this join is immediate.
+    if (compactor.joinable()) compactor.join();
+    // The packed heap, index and filters are built off-lock from frozen segments; readers and writers
+    // are held off only while the writes made meanwhile are carried over and the result is swapped in.
+    compactor = std::jthread([this] {
+        std::unique_ptr<CompactedHeap> heap;
+        {
+            std::shared_lock lock(tableMutex);
+            heap = captureCompaction();
+        }
+        buildCompacted(*heap);
+        std::unique_lock lock(tableMutex);
+        installCompacted(*heap);
+        compactionScheduled = false;
+    });
+}
+
+void Table::forEachLsmRecord(const std::function<bool(const Record&)>& fn) const {
+    lsm->scan(std::nullopt, std::nullopt, fn);
+}
+
+std::vector<Value> Table::lsmMatchingKeys(const std::string& column, const Value& value) const {
+    std::vector<Value> keys;
+    if (column == indexedColumnName) {
+        if (lsm->get(value)) keys.push_back(value);
+        return keys;
+    }
+    forEachLsmRecord([&](const Record& record) {
+        auto it = record.find(column);
+        if (it != record.end() && it->second == value) keys.push_back(record.at(indexedColumnName));
+        return true;
+    });
+    return keys;
+}
+
+std::size_t Table::updateLsm(const std::string& column, const Value& value, const Record& changes) {
+    auto keys = lsmMatchingKeys(column, value);
+    std::vector<Record> updated;
+    updated.reserve(keys.size());
+    for (const auto& key : keys) {
+        Record rec = *lsm->get(key);
+        for (const auto& [name, val] : changes) rec[name] = val;
+        validate(rec);
+        updated.push_back(std::move(rec));
+    }
+    auto keyChange = changes.find(indexedColumnName);
+    if (keyChange != changes.end() && !keys.empty()) {
+        if (keys.size() > 1)
+            throw std::runtime_error("Update would duplicate key for column: " + indexedColumnName);
+        if (keyChange->second != keys.front() && lsm->get(keyChange->second))
+            throw std::runtime_error("Duplicate key for column: " + indexedColumnName);
+        if (keyChange->second != keys.front()) lsm->remove(keys.front());
+    }
+    for (const auto& rec : updated) lsm->put(rec);
+    return keys.size();
+}
+
+void TableSnapshot::forEachLsmRecord(const std::function<bool(const Record&)>& fn) const {
+    lsmView->scan(fn);
 }
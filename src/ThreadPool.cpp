@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        const auto hardware = std::thread::hardware_concurrency();
+        threads = hardware > 1 ? hardware - 1 : 0;
+    }
+    workers.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(queueMutex);
+            queueCv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (count == 0) return;
+    // Shared with the helper tasks, which may be dequeued after this call has returned;
+    // by then every index is claimed and they leave without touching fn.
+    struct Batch {
+        std::atomic<std::size_t> next{0};
+        std::size_t count = 0;
+        const std::function<void(std::size_t)>* fn = nullptr;
+        std::mutex doneMutex;
+        std::condition_variable doneCv;
+        std::size_t done = 0;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->count = count;
+    batch->fn = &fn;
+    auto work = [batch] {
+        for (std::size_t i; (i = batch->next.fetch_add(1)) < batch->count;) {
+            std::exception_ptr error;
+            {
+                std::lock_guard lock(batch->doneMutex);
+                error = batch->error;
+            }
+            if (!error) {
+                try {
+                    (*batch->fn)(i);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            std::lock_guard lock(batch->doneMutex);
+            if (error && !batch->error) batch->error = error;
+            if (++batch->done == batch->count) batch->doneCv.notify_all();
+        }
+    };
+
+    const std::size_t helpers = std::min(workers.size(), count - 1);
+    if (helpers > 0) {
+        {
+            std::lock_guard lock(queueMutex);
+            for (std::size_t h = 0; h < helpers; ++h) queue.emplace_back(work);
+        }
+        queueCv.notify_all();
+    }
+    work();
+    std::unique_lock lock(batch->doneMutex);
+    batch->doneCv.wait(lock, [&] { return batch->done == batch->count; });
+    if (batch->error) std::rethrow_exception(batch->error);
+}
@@ -1,79 +1,81 @@
 #include <iostream>
-#include <sstream>
 #include <vector>
 #include <algorithm>
 #include <ranges>
-#include <unordered_map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include "CommandType.h"
 #include "CommandMap.h"
 #include "CommandHandlers.h"
+#include "CommandParser.h"
 #include "Database.h"
 // <iomanip> is required ONLY for help message alignment using std::setw below.
 
-// ----------- Utility functions -----------
-
-inline std::unordered_map<std::string, std::string> parseKeyValuePairs(const std::vector<std::string>& args) {
-    std::unordered_map<std::string, std::string> kv;
-    for (const auto& arg : args) {
-        auto eqPos = arg.find('=');
-        if (eqPos != std::string::npos) {
-            auto key = arg.substr(0, eqPos);
-            auto val = arg.substr(eqPos + 1);
-            kv[key] = val;
-        }
-    }
-    return kv;
-}
-
-inline std::vector<Column> parseColumnDefinitions(const std::vector<std::string>& args) {
-    std::vector<Column> columns;
-    for (const auto& arg : args) {
-        auto pos = arg.find(':');
-        if (pos == std::string::npos) continue;
-        std::string name = arg.substr(0, pos);
-        std::string type = arg.substr(pos + 1);
-        DataType dt;
-        if      (type == "int")    dt = DataType::Integer;
-        else if (type == "float")  dt = DataType::Float;
-        else if (type == "string") dt = DataType::String;
-        else throw std::runtime_error("Invalid type: " + type);
-        columns.push_back({name, dt});
-    }
-    return columns;
+// Prints one record as a tab-separated line, in schema column order.
+static void printRecord(const std::vector<Column>& columns, const Record& rec) {
+    std::ranges::for_each(columns, [&](const Column& col) {
+        const auto& val = rec.at(col.name);
+        if (col.type == DataType::Integer)
+            std::cout << std::get<int>(val) << "\t";
+        else if (col.type == DataType::Float)
+            std::cout << std::get<float>(val) << "\t";
+        else
+            std::cout << std::get<std::string>(val) << "\t";
+    });
+    std::cout << "\n";
 }
 
 // ----------- Main CLI -----------
 
 int main() {
     std::unique_ptr<Database> db;
+    std::string dbPath;     // file the current database was created from or loaded from
     CommandDispatcher dispatcher;
 
-    dispatcher.registerHandler(CommandType::Create, [&](const std::vector<std::string>& args) {
+    dispatcher.registerHandler(CommandType::Create, [&](CommandArgs args) {
         if (args.empty()) { std::cout << "Usage: create <filename>\n"; return; }
+        dbPath = args[0];
         db = std::make_unique<Database>();
-        db->saveToFile(args[0]);
-        std::cout << "Empty database created and saved to " << args[0] << "\n";
+        db->saveToFile(dbPath);
+        std::cout << "Empty database created and saved to " << dbPath << "\n";
     });
 
-    dispatcher.registerHandler(CommandType::Load, [&](const std::vector<std::string>& args) {
+    dispatcher.registerHandler(CommandType::Load, [&](CommandArgs args) {
         if (args.empty()) { std::cout << "Usage: load <filename>\n"; return; }
-        db = Database::loadFromFile(args[0]);
+        if (db) db->waitForCheckpoint();    // the file may be the one a checkpoint is still writing
+        db = Database::loadFromFile(std::string(args[0]));
+        dbPath = db ? args[0] : "";
         std::cout << (db ? "Loaded DB from " : "Failed to load ") << args[0] << "\n";
     });
 
-    dispatcher.registerHandler(CommandType::CreateTable, [&](const std::vector<std::string>& args) {
+    dispatcher.registerHandler(CommandType::CreateTable, [&](CommandArgs args) {
         if (!db) { std::cout << "No database loaded.\n"; return; }
         if (args.size() < 2) {
-            std::cout << "Usage: create_table <table> <col1>:<type> <col2>:<type> ...\n";
+            std::cout << "Usage: create_table <table> [engine=btree|lsm] [key=<col>,<col>...] <col1>:<type> <col2>:<type> ...\n";
             std::cout << "Types: int, float, string\n";
             return;
         }
         try {
-            const std::string& tableName = args[0];
-            auto columns = parseColumnDefinitions({args.begin() + 1, args.end()});
-            TableSchema schema(tableName, columns);
+            const std::string tableName(args[0]);
+            auto defs = args.subspan(1);
+            TableEngine engine = TableEngine::BTree;
+            std::vector<std::string> primaryKey;
+            for (auto kv = splitKeyValue(defs.front()); kv; kv = defs.empty() ? std::nullopt : splitKeyValue(defs.front())) {
+                if (kv->first == "engine") {
+                    if (kv->second == "lsm") engine = TableEngine::Lsm;
+                    else if (kv->second != "btree") throw std::runtime_error("Unknown engine: " + std::string(kv->second));
+                } else if (kv->first == "key") {
+                    for (auto part : std::views::split(kv->second, ','))
+                        primaryKey.emplace_back(std::string_view(part.begin(), part.end()));
+                } else {
+                    throw std::runtime_error("Unknown option: " + std::string(kv->first));
+                }
+                defs = defs.subspan(1);
+            }
+            auto columns = parseColumnDefinitions(defs);
+            TableSchema schema(tableName, columns, engine, std::move(primaryKey));
             db->createTable(schema);
             std::cout << "Table '" << tableName << "' created.\n";
         } catch (const std::exception& ex) {
@@ -81,83 +83,162 @@ int main() {
         }
     });
 
-    dispatcher.registerHandler(CommandType::Insert, [&](const std::vector<std::string>& args) {
+    dispatcher.registerHandler(CommandType::Insert, [&](CommandArgs args) {
         if (!db) { std::cout << "No database loaded.\n"; return; }
         if (args.size() < 2) {
             std::cout << "Usage: insert <table> <col1>=<val1> <col2>=<val2> ...\n";
             return;
         }
-        const std::string& tableName = args[0];
+        std::string_view tableName = args[0];
         Table* table = db->getTable(tableName);
         if (!table) {
             std::cout << "Table '" << tableName << "' does not exist.\n";
             return;
         }
-        auto kv = parseKeyValuePairs({args.begin() + 1, args.end()});
-        Record record;
-        const auto& columns = table->schema().getColumns();
-        for (const auto& col : columns) {
-            auto it = kv.find(col.name);
-            if (it == kv.end()) {
-                std::cout << "Missing value for column: " << col.name << "\n";
-                return;
-            }
-            if (col.type == DataType::Integer)      record[col.name] = std::stoi(it->second);
-            else if (col.type == DataType::Float)   record[col.name] = std::stof(it->second);
-            else                                    record[col.name] = it->second;
-        }
-        table->insert(record);
+        table->insert(parseRecord(table->schema(), args.subspan(1)));
         std::cout << "Inserted record into '" << tableName << "'.\n";
     });
 
-    dispatcher.registerHandler(CommandType::Select, [&](const std::vector<std::string>& args) {
+    // --- select: select <table> [order by <col> [asc|desc]] [limit <n>] ---
+    dispatcher.registerHandler(CommandType::Select, [&](CommandArgs args) {
         if (!db) { std::cout << "No database loaded.\n"; return; }
         if (args.empty()) { std::cout << "Usage: select <table>\n"; return; }
-        const std::string& tableName = args[0];
+        std::string_view tableName = args[0];
         Table* table = db->getTable(tableName);
         if (!table) {
             std::cout << "Table '" << tableName << "' does not exist.\n";
             return;
         }
-        const auto& records = table->getRecords();
+        std::string_view orderColumn;
+        SortOrder order = SortOrder::Ascending;
+        std::size_t limit = Table::kNoLimit;
+        auto rest = args.subspan(1);
+        if (rest.size() >= 3 && equalsLower(rest[0], "order") && equalsLower(rest[1], "by")) {
+            orderColumn = rest[2];
+            rest = rest.subspan(3);
+            if (!rest.empty() && (equalsLower(rest[0], "asc") || equalsLower(rest[0], "desc"))) {
+                if (equalsLower(rest[0], "desc")) order = SortOrder::Descending;
+                rest = rest.subspan(1);
+            }
+        }
+        if (rest.size() == 2 && equalsLower(rest[0], "limit")) {
+            auto [ptr, ec] = std::from_chars(rest[1].data(), rest[1].data() + rest[1].size(), limit);
+            if (ec != std::errc{} || ptr != rest[1].data() + rest[1].size()) {
+                std::cout << "Invalid limit: " << rest[1] << "\n";
+                return;
+            }
+            rest = rest.subspan(2);
+        }
+        if (!rest.empty()) {
+            std::cout << "Usage: select <table> [order by <col> [asc|desc]] [limit <n>]\n";
+            return;
+        }
         const auto& columns = table->schema().getColumns();
         // Print header
         std::ranges::for_each(columns, [](const Column& col) { std::cout << col.name << "\t"; });
         std::cout << "\n";
-        std::ranges::for_each(records, [&](const Record& rec) {
-            std::ranges::for_each(columns, [&](const Column& col) {
-                const auto& val = rec.at(col.name);
-                if (col.type == DataType::Integer)
-                    std::cout << std::get<int>(val) << "\t";
-                else if (col.type == DataType::Float)
-                    std::cout << std::get<float>(val) << "\t";
-                else
-                    std::cout << std::get<std::string>(val) << "\t";
+        if (orderColumn.empty()) {
+            if (limit == 0) return;
+            std::size_t printed = 0;
+            table->forEachRecord([&](const Record& rec) {
+                printRecord(columns, rec);
+                return ++printed < limit;
             });
-            std::cout << "\n";
-        });
+            return;
+        }
+        std::size_t printed = 0;
+        const OrderByPlan plan = table->orderBy(std::string(orderColumn), order, limit, [&](const Record& rec) {
+            printRecord(columns, rec);
+            printed++;
+            return true;
+        }, &db->loadPool());
+        std::cout << "(" << printed << " row(s), " << to_string(plan) << ")\n";
     });
 
-    // --- select_where: select <table> where <col>=<val> ---
-    dispatcher.registerHandler(CommandType::SelectWhere, [&](const std::vector<std::string>& args) {
+    // --- select_where: select <table> where <col>=<val> | <col><op><val> ... (op: < <= > >=) ---
+    dispatcher.registerHandler(CommandType::SelectWhere, [&](CommandArgs args) {
         if (!db) { std::cout << "No database loaded.\n"; return; }
-        if (args.size() < 4 || args[1] != "where") {
+        if (args.size() < 3 || args[1] != "where") {
             std::cout << "Usage: select <table> where <col>=<val>\n";
             return;
         }
-        const std::string& tableName = args[0];
+        std::string_view tableName = args[0];
         Table* table = db->getTable(tableName);
         if (!table) {
             std::cout << "Table '" << tableName << "' does not exist.\n";
             return;
         }
         const auto& columns = table->schema().getColumns();
-        std::string column, valueString;
+        // Range: every predicate bounds the same column, e.g. where ts>=100 ts<200; zone maps skip segments.
+        if (args[2].find_first_of("<>") != std::string_view::npos) {
+            std::string_view column;
+            ValueRange range;
+            for (auto arg : args.subspan(2)) {
+                const auto opPos = arg.find_first_of("<>");
+                if (opPos == std::string_view::npos || (!column.empty() && arg.substr(0, opPos) != column)) {
+                    std::cout << "Usage: select <table> where <col><op><val> ... (op: < <= > >=, one column)\n";
+                    return;
+                }
+                column = arg.substr(0, opPos);
+                const Column* col = findColumn(table->schema(), column);
+                if (!col) {
+                    std::cout << "Column '" << column << "' not found in schema.\n";
+                    return;
+                }
+                const bool inclusive = arg.size() > opPos + 1 && arg[opPos + 1] == '=';
+                const Value bound = parseValue(*col, arg.substr(opPos + (inclusive ? 2 : 1)));
+                if (arg[opPos] == '<') {
+                    range.upper = bound;
+                    range.upperInclusive = inclusive;
+                } else {
+                    range.lower = bound;
+                    range.lowerInclusive = inclusive;
+                }
+            }
+            std::ranges::for_each(columns, [](const Column& col) { std::cout << col.name << "\t"; });
+            std::cout << "\n";
+            const auto before = table->zoneMapStats();
+            const auto n = table->scanRange(std::string(column), range, [&](const Record& rec) {
+                printRecord(columns, rec);
+                return true;
+            });
+            const auto after = table->zoneMapStats();
+            const auto skipped = after.blocksSkipped - before.blocksSkipped;
+            std::cout << "(" << n << " row(s); zone maps skipped " << skipped << " of "
+                      << skipped + after.blocksScanned - before.blocksScanned << " blocks)\n";
+            return;
+        }
+        // Composite key: select <table> where <key1>=<val1> <key2>=<val2> ... (every key column, any order)
+        if (const auto& keyColumns = table->keyColumns(); keyColumns.size() > 1 && args.size() > 3) {
+            const auto where = args.subspan(2);
+            std::vector<Value> key;
+            for (const auto& name : keyColumns) {
+                auto arg = std::ranges::find_if(where, [&](std::string_view a) {
+                    auto kv = splitKeyValue(a);
+                    return kv && kv->first == name;
+                });
+                if (arg == where.end()) {
+                    std::cout << "Missing value for key column: " << name << "\n";
+                    return;
+                }
+                key.push_back(parseValue(*findColumn(table->schema(), name), splitKeyValue(*arg)->second));
+            }
+            auto rec = table->findByKey(key);
+            if (!rec) {
+                std::cout << "No record found with that key.\n";
+                return;
+            }
+            std::ranges::for_each(columns, [](const Column& col) { std::cout << col.name << "\t"; });
+            std::cout << "\n";
+            printRecord(columns, *rec);
+            return;
+        }
+        std::string_view column, valueString;
         auto eqPos = args[2].find('=');
-        if(eqPos != std::string::npos) {
+        if(eqPos != std::string_view::npos) {
             column = args[2].substr(0, eqPos);
             valueString = args[2].substr(eqPos+1);
-        } else if (args.size() > 3 && args[3].find('=') != std::string::npos) {
+        } else if (args.size() > 3 && args[3].find('=') != std::string_view::npos) {
             column = args[2];
             valueString = args[3].substr(args[3].find('=') + 1);
         } else {
@@ -171,80 +252,183 @@ int main() {
         }
         Value key;
         try {
-            if (colIt->type == DataType::Integer)
-                key = std::stoi(valueString);
-            else if (colIt->type == DataType::Float)
-                key = std::stof(valueString);
-            else
-                key = valueString;
+            key = parseValue(*colIt, valueString);
         } catch (const std::exception& ex) {
             std::cout << "Value parse error: " << ex.what() << "\n";
             return;
         }
         bool usedIndex = false;
-        if (colIt == columns.begin() && table->isIndexed()) {
-            const Record* rec = table->findByKey(key);
+        if (table->isIndexed() && colIt->name == table->indexColumn()) {
+            auto rec = table->findByKey(key);
             if (rec) {
                 for (const auto& col : columns)
                     std::cout << col.name << "\t";
                 std::cout << "\n";
-                for (const auto& col : columns) {
-                    const auto& val = rec->at(col.name);
-                    if (col.type == DataType::Integer)
-                        std::cout << std::get<int>(val) << "\t";
-                    else if (col.type == DataType::Float)
-                        std::cout << std::get<float>(val) << "\t";
-                    else
-                        std::cout << std::get<std::string>(val) << "\t";
-                }
-                std::cout << "\n";
-                usedIndex = true;
+                printRecord(columns, *rec);
+            } else {
+                std::cout << "No record found with " << column << "=" << valueString << "\n";
             }
+            usedIndex = true;
         }
         if (!usedIndex) {
             bool found = false;
-            auto recIt = std::ranges::find_if(
-                table->getRecords(),
-                [&](const Record& rec) {
-                    auto it = rec.find(column);
-                    return it != rec.end() && it->second == key;
-                });
-            if (recIt != table->getRecords().end()) {
+            auto recIt = table->findFirst(std::string(column), key);
+            if (recIt) {
                 std::ranges::for_each(columns, [](const Column& col) { std::cout << col.name << "\t"; });
                 std::cout << "\n";
-                std::ranges::for_each(columns, [&](const Column& col) {
-                    const auto& val = recIt->at(col.name);
-                    if (col.type == DataType::Integer)
-                        std::cout << std::get<int>(val) << "\t";
-                    else if (col.type == DataType::Float)
-                        std::cout << std::get<float>(val) << "\t";
-                    else
-                        std::cout << std::get<std::string>(val) << "\t";
-                });
-                std::cout << "\n";
+                printRecord(columns, *recIt);
                 found = true;
             }
             if (!found) std::cout << "No record found with " << column << "=" << valueString << "\n";
         }
     });
-        // Startup message only; suppress command list for minimal prompt.
+    // --- delete: delete <table> where <col>=<val> ---
+    dispatcher.registerHandler(CommandType::Delete, [&](CommandArgs args) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        auto where = args.size() == 3 && args[1] == "where" ? splitKeyValue(args[2]) : std::nullopt;
+        if (!where) {
+            std::cout << "Usage: delete <table> where <col>=<val>\n";
+            return;
+        }
+        Table* table = db->getTable(args[0]);
+        const auto& [column, valueString] = *where;
+        const Column* col = findColumn(table->schema(), column);
+        if (!col) {
+            std::cout << "Column '" << column << "' not found in schema.\n";
+            return;
+        }
+        std::size_t n = table->erase(col->name, parseValue(*col, valueString));
+        std::cout << "Deleted " << n << " record(s) from '" << args[0] << "'.\n";
+    });
+
+    // --- update: update <table> set <col>=<val> ... where <col>=<val> ---
+    dispatcher.registerHandler(CommandType::Update, [&](CommandArgs args) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        auto whereIt = std::ranges::find(args, std::string_view("where"));
+        auto where = whereIt != args.end() && whereIt + 2 == args.end() ? splitKeyValue(whereIt[1]) : std::nullopt;
+        const auto usage = [] { std::cout << "Usage: update <table> set <col>=<val> ... where <col>=<val>\n"; };
+        if (args.size() < 5 || args[1] != "set" || whereIt == args.begin() + 2 || !where) {
+            usage();
+            return;
+        }
+        Table* table = db->getTable(args[0]);
+        Record changes;
+        for (auto arg : std::ranges::subrange(args.begin() + 2, whereIt)) {
+            auto kv = splitKeyValue(arg);
+            if (!kv) {
+                usage();
+                return;
+            }
+            const Column* col = findColumn(table->schema(), kv->first);
+            if (!col) {
+                std::cout << "Column '" << kv->first << "' not found in schema.\n";
+                return;
+            }
+            changes[col->name] = parseValue(*col, kv->second);
+        }
+        if (changes.empty()) {
+            usage();
+            return;
+        }
+        const auto& [column, valueString] = *where;
+        const Column* col = findColumn(table->schema(), column);
+        if (!col) {
+            std::cout << "Column '" << column << "' not found in schema.\n";
+            return;
+        }
+        std::size_t n = table->update(col->name, parseValue(*col, valueString), changes);
+        std::cout << "Updated " << n << " record(s) in '" << args[0] << "'.\n";
+    });
+
+    // --- checkpoint: checkpoint [file] (defaults to the file the database came from) ---
+    dispatcher.registerHandler(CommandType::Checkpoint, [&](CommandArgs args) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        const std::string target = args.empty() ? dbPath : std::string(args[0]);
+        if (target.empty()) { std::cout << "Usage: checkpoint [file]\n"; return; }
+        if (db->checkpoint(target))
+            std::cout << "Checkpoint to " << target << " started in background.\n";
+        else
+            std::cout << "A checkpoint is already running.\n";
+    });
+
+    dispatcher.registerHandler(CommandType::CheckpointStatus, [&](CommandArgs) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        const auto stats = db->checkpointStats();
+        std::cout << (stats.running ? "running" : "idle")
+                  << ": " << stats.rowsWritten << "/" << stats.rowsTotal << " rows, "
+                  << stats.bytesWritten << " bytes, capture " << stats.captureTime.count() << " us, "
+                  << "last duration " << stats.duration.count() << " ms, "
+                  << stats.completed << " completed\n";
+        if (!stats.lastError.empty()) std::cout << "Last error: " << stats.lastError << "\n";
+    });
+
+    // --- bloom: bloom <table> [<col> ...] [bits=<n>] ---
+    dispatcher.registerHandler(CommandType::Bloom, [&](CommandArgs args) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        if (args.empty()) { std::cout << "Usage: bloom <table> [<col> ...] [bits=<n>]\n"; return; }
+        Table* table = db->getTable(args[0]);
+        for (auto arg : args.subspan(1)) {
+            if (auto kv = splitKeyValue(arg); kv && kv->first == "bits")
+                table->setBloomBitsPerKey(static_cast<std::size_t>(std::get<int>(parseValue({"bits", DataType::Integer}, kv->second))));
+            else
+                table->addBloomFilter(std::string(arg));
+        }
+        const auto stats = table->bloomStats();
+        std::cout << "Bloom filters on '" << args[0] << "' (" << table->bloomBitsPerKey() << " bits/key):";
+        for (const auto& col : table->bloomFilterColumns()) std::cout << " " << col;
+        std::cout << "\n" << stats.probes << " probes, " << stats.negatives << " negatives, "
+                  << stats.falsePositives << " false positives (rate " << stats.falsePositiveRate() << ")\n";
+    });
+
+    // --- zones: zones <table> [<col> ...] ---
+    dispatcher.registerHandler(CommandType::Zones, [&](CommandArgs args) {
+        if (!db) { std::cout << "No database loaded.\n"; return; }
+        if (args.empty()) { std::cout << "Usage: zones <table> [<col> ...]\n"; return; }
+        Table* table = db->getTable(args[0]);
+        std::vector<std::string> names;
+        for (auto arg : args.subspan(1)) names.emplace_back(arg);
+        if (names.empty()) {
+            for (const auto& col : table->schema().getColumns()) names.push_back(col.name);
+        }
+        const auto stats = table->zoneMapStats();
+        std::cout << "Zone maps on '" << args[0] << "': " << stats.blocksScanned << " blocks scanned, "
+                  << stats.blocksSkipped << " skipped\n";
+        for (const auto& name : names) {
+            const auto zones = table->zoneMaps(name);
+            double distinct = 0;
+            for (const auto& zone : zones) distinct += zone.distinctEstimate();
+            std::cout << "  " << name << ": " << zones.size() << " blocks, ~"
+                      << (zones.empty() ? 0.0 : distinct / static_cast<double>(zones.size())) << " distinct/block\n";
+        }
+    });
+
+    // Startup message only; suppress command list for minimal prompt.
         // std::cout << "Supported commands: ..." << std::endl; // now shown only via 'help'
 
-    dispatcher.registerHandler(CommandType::Help, [&](const std::vector<std::string>&) {
+    dispatcher.registerHandler(CommandType::Help, [&](CommandArgs) {
 #include <iomanip>
         std::vector<std::pair<std::string, std::string>> help_entries = {
             {"create <file>", "Create a new (empty) database"},
             {"load <file>", "Load existing database"},
-            {"create_table <table> <col>:<type> ...", "Create table/schema (types: int, float, string)"},
+            {"create_table <table> [engine=lsm] [key=<cols>] <col>:<type> ...", "Create table/schema (types: int, float, string)"},
             {"insert <table> <col>=<val> ...", "Insert record into table"},
             {"select <table>", "Display all records from table"},
+            {"select <table> order by <col> [asc|desc] [limit <n>]", "Sorted/top-N rows (streams the index when <col> is the key)"},
             {"select <table> where <column>=<value>", "Find and print a record by key (fast if indexed, else linear)"},
+            {"select <table> where <k1>=<v1> <k2>=<v2> ...", "Find a record by its full composite key"},
+            {"select <table> where <col>>=<lo> <col><<hi>", "Range filter (< <= > >=); zone maps skip blocks"},
+            {"delete <table> where <column>=<value>", "Delete matching records (O(log N) by key)"},
+            {"update <table> set ... where <col>=<val>", "Update matching records (set <col>=<val> ...)"},
+            {"checkpoint [file]", "Save a snapshot in the background (temp file + atomic rename)"},
+            {"checkpoint_status", "Show progress and timing of the last checkpoint"},
+            {"bloom <table> [<col> ...] [bits=<n>]", "Add Bloom filters / set bits per key; show hit stats"},
+            {"zones <table> [<col> ...]", "Show zone map block counts and skipped/scanned stats"},
             {"help", "Show this message"},
             {"exit", "Quit MarinaDB CLI"}
         };
         std::cout << "Supported commands:\n";
         for (const auto& entry : help_entries) {
-            std::cout << "  " << std::left << std::setw(40) << entry.first << entry.second << "\n";
+            std::cout << "  " << std::left << std::setw(65) << entry.first << entry.second << "\n";
         }
     });
 
@@ -252,17 +436,16 @@ int main() {
     // --- Main Loop ---
     std::cout << "MarinaDB CLI v0.2. Type 'help' for commands.\n";
     std::cout << "(C) 2024-2025 Ilija Mandic. All rights reserved.\n";
+    // Both buffers are reused across lines; tokens are views into 'line'.
     std::string line;
+    std::vector<std::string_view> tokens;
     try {
         while (std::cout << "marina> ", std::getline(std::cin, line)) {
             try {
-                std::istringstream iss(line);
-                std::string cmdWord;
-                iss >> cmdWord;
-                std::vector<std::string> args;
-                for (std::string arg; iss >> arg;) args.push_back(arg);
-                std::ranges::transform(cmdWord, cmdWord.begin(), ::tolower);
-                CommandType cmd = parseCommand(cmdWord, args);
+                tokenize(line, tokens);
+                if (tokens.empty()) continue;
+                CommandArgs args = CommandArgs(tokens).subspan(1);
+                CommandType cmd = parseCommand(tokens.front(), args);
                 if (cmd == CommandType::Exit) break;
                 dispatcher.dispatch(cmd, args);
             } catch (const std::exception& ex) {
@@ -0,0 +1,104 @@
+// benchmark_checkpoint.cpp
+// Benchmark for background checkpoints: inserts keep running into a heap table and an LSM table
+// while a checkpoint writes them out, and their latency is compared with inserts on an idle
+// database. The checkpoint file is then reloaded and its row counts compared with the tables
+// at capture time; a second checkpoint must match the live row counts.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <filesystem>
+#include <thread>
+#include "../include/Database.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+    constexpr int HeapRows = 500000;
+    constexpr int LsmRows = 200000;
+    const auto path = filesystem::temp_directory_path() / "benchmark_checkpoint.marina";
+
+    Database db;
+    db.createTable(TableSchema("events", {{"id", DataType::Integer}, {"payload", DataType::String}}));
+    db.createTable(TableSchema("log", {{"id", DataType::Integer}, {"payload", DataType::String}}, TableEngine::Lsm));
+    Table* events = db.getTable("events");
+    Table* log = db.getTable("log");
+    for (int i = 0; i < HeapRows; ++i) events->insert({{"id", i}, {"payload", "event_" + to_string(i)}});
+    for (int i = 0; i < LsmRows; ++i) log->insert({{"id", i}, {"payload", "log_" + to_string(i)}});
+
+    int nextId = max(HeapRows, LsmRows);
+    auto insertPair = [&] {
+        const int id = nextId++;
+        auto t1 = high_resolution_clock::now();
+        events->insert({{"id", id}, {"payload", string("late")}});
+        log->insert({{"id", id}, {"payload", string("late")}});
+        return duration_cast<nanoseconds>(high_resolution_clock::now() - t1).count() / 1000.0;
+    };
+
+    // Baseline: the same inserts with no checkpoint running.
+    constexpr int BaselineInserts = 20000;
+    double baselineTotal = 0.0, baselineMax = 0.0;
+    for (int i = 0; i < BaselineInserts; ++i) {
+        const double us = insertPair();
+        baselineTotal += us;
+        baselineMax = max(baselineMax, us);
+    }
+    const size_t capturedEvents = events->liveRowCount();
+    const size_t capturedLog = log->liveRowCount();
+
+    auto t1 = high_resolution_clock::now();
+    if (!db.checkpoint(path)) {
+        cout << "Checkpoint did not start!\n";
+        return 1;
+    }
+    auto t2 = high_resolution_clock::now();
+    size_t during = 0;
+    double duringTotal = 0.0, duringMax = 0.0;
+    while (db.checkpointStats().running) {
+        const double us = insertPair();
+        duringTotal += us;
+        duringMax = max(duringMax, us);
+        ++during;
+    }
+    db.waitForCheckpoint();
+    auto t3 = high_resolution_clock::now();
+    const auto stats = db.checkpointStats();
+
+    auto loaded = Database::loadFromFile(path);
+    const size_t loadedEvents = loaded->getTable("events")->liveRowCount();
+    const size_t loadedLog = loaded->getTable("log")->liveRowCount();
+    loaded.reset();
+
+    db.checkpoint(path);
+    db.waitForCheckpoint();
+    loaded = Database::loadFromFile(path);
+    const bool liveMatch = loaded->getTable("events")->liveRowCount() == events->liveRowCount()
+                           && loaded->getTable("log")->liveRowCount() == log->liveRowCount();
+    loaded.reset();
+
+    auto ms = [](auto d) { return duration_cast<microseconds>(d).count() / 1000.0; };
+    cout << fixed << setprecision(3);
+    cout << "Checkpoint of " << capturedEvents + capturedLog << " rows, " << stats.bytesWritten / (1024.0 * 1024.0)
+         << " MB\n";
+    cout << "checkpoint() returned after: " << ms(t2 - t1) << " ms (capture " << stats.captureTime.count() / 1000.0
+         << " ms)\n";
+    cout << "Checkpoint finished after:   " << ms(t3 - t1) << " ms\n";
+    cout << "Idle inserts:                " << BaselineInserts << ", avg " << baselineTotal / BaselineInserts
+         << " us, max " << baselineMax << " us\n";
+    cout << "Inserts during checkpoint:   " << during << ", avg " << (during ? duringTotal / during : 0.0)
+         << " us, max " << duringMax << " us\n";
+    cout << "Reloaded rows: events " << loadedEvents << "/" << capturedEvents << ", log " << loadedLog << "/"
+         << capturedLog << "\n";
+    filesystem::remove(path);
+    if (!stats.lastError.empty()) {
+        cout << "Checkpoint failed: " << stats.lastError << "\n";
+        return 1;
+    }
+    if (loadedEvents != capturedEvents || loadedLog != capturedLog || !liveMatch) {
+        cout << "Row count mismatch!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// benchmark_churn.cpp
+// Benchmark for delete/update churn: rounds of erasing, updating and re-inserting a fifth of the
+// rows each, printing tombstones, live rows and key-lookup latency after every phase, once with
+// background compaction off and once at the default threshold, then after an explicit compact().
+
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include "../include/Table.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+    constexpr int N = 200000;
+    constexpr int kRounds = 5;
+    constexpr int kChurn = N / 5;
+    constexpr int kLookups = 20000;
+    auto us = [](auto d) { return duration_cast<nanoseconds>(d).count() / 1000.0; };
+    bool ok = true;
+
+    for (double threshold : {2.0, 0.3}) {
+        Table table(TableSchema("accounts", {{"id", DataType::Integer}, {"balance", DataType::Integer}}));
+        table.setCompactionThreshold(threshold);
+        vector<int> live(N);
+        auto loadStart = high_resolution_clock::now();
+        for (int i = 0; i < N; ++i) {
+            live[i] = i;
+            table.insert(Record{{"id", i}, {"balance", 0}});
+        }
+        const double loadMs = us(high_resolution_clock::now() - loadStart) / 1000.0;
+        int nextId = N;
+        mt19937 rng(42);
+
+        auto report = [&](const string& phase, double ms) {
+            double total = 0.0;
+            size_t missing = 0;
+            for (int i = 0; i < kLookups; ++i) {
+                const int id = live[rng() % live.size()];
+                auto t1 = high_resolution_clock::now();
+                missing += !table.findByKey(id).has_value();
+                total += us(high_resolution_clock::now() - t1);
+            }
+            cout << setw(22) << left << phase << right << setw(10) << ms << " ms" << setw(12) << table.tombstoneCount()
+                 << setw(12) << table.liveRowCount() << setw(12) << total / kLookups << "\n";
+            if (missing || table.liveRowCount() != live.size()) ok = false;
+        };
+
+        cout << fixed << setprecision(3);
+        cout << "Compaction threshold " << threshold << (threshold > 1.0 ? " (background compaction off)" : "") << "\n";
+        cout << setw(22) << left << "phase" << right << setw(13) << "time" << setw(12) << "tombstones"
+             << setw(12) << "live rows" << setw(12) << "us/lookup" << "\n";
+        report("load", loadMs);
+        for (int round = 1; round <= kRounds; ++round) {
+            shuffle(live.begin(), live.end(), rng);
+            auto t1 = high_resolution_clock::now();
+            for (int i = 0; i < kChurn; ++i) table.erase("id", live[i]);
+            auto t2 = high_resolution_clock::now();
+            live.erase(live.begin(), live.begin() + kChurn);
+            report("round " + to_string(round) + " erase", us(t2 - t1) / 1000.0);
+
+            t1 = high_resolution_clock::now();
+            for (int i = 0; i < kChurn; ++i) table.update("id", live[i], Record{{"balance", round}});
+            t2 = high_resolution_clock::now();
+            report("round " + to_string(round) + " update", us(t2 - t1) / 1000.0);
+
+            t1 = high_resolution_clock::now();
+            for (int i = 0; i < kChurn; ++i) {
+                live.push_back(nextId);
+                table.insert(Record{{"id", nextId++}, {"balance", round}});
+            }
+            t2 = high_resolution_clock::now();
+            report("round " + to_string(round) + " insert", us(t2 - t1) / 1000.0);
+        }
+        auto t1 = high_resolution_clock::now();
+        table.compact();
+        auto t2 = high_resolution_clock::now();
+        report("compact()", us(t2 - t1) / 1000.0);
+        cout << "\n";
+    }
+    if (!ok) {
+        cout << "Live row or lookup mismatch!\n";
+        return 1;
+    }
+    return 0;
+}
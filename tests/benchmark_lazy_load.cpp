@@ -0,0 +1,63 @@
+// benchmark_lazy_load.cpp
+// Benchmark for lazy table loading: a database with several large tables and one small one is
+// loaded and only the small table is queried, then every table is touched. With the table
+// directory the first number tracks the table count, not the size of the file.
+
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <filesystem>
+#include "../include/Database.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+    constexpr int LargeTables = 8;
+    constexpr int RowsPerTable = 200000;
+    const auto path = filesystem::temp_directory_path() / "benchmark_lazy_load.marina";
+
+    {
+        Database db;
+        for (int t = 0; t < LargeTables; ++t) {
+            const string name = "large" + to_string(t);
+            db.createTable(TableSchema(name, {{"id", DataType::Integer}, {"payload", DataType::String}}));
+            Table* table = db.getTable(name);
+            for (int i = 0; i < RowsPerTable; ++i) {
+                Record rec;
+                rec["id"] = i;
+                rec["payload"] = "payload_" + to_string(i);
+                table->insert(std::move(rec));
+            }
+        }
+        db.createTable(TableSchema("small", {{"id", DataType::Integer}, {"name", DataType::String}}));
+        db.getTable("small")->insert({{"id", 1}, {"name", string("Alice")}});
+        db.saveToFile(path);
+    }
+
+    // Untimed open first: the first read of a just-written file includes flushing it.
+    Database::loadFromFile(path);
+
+    auto t1 = high_resolution_clock::now();
+    auto db = Database::loadFromFile(path);
+    auto t2 = high_resolution_clock::now();
+    auto found = db->getTable("small")->findByKey(1);
+    auto t3 = high_resolution_clock::now();
+    std::size_t rows = 0;
+    for (int t = 0; t < LargeTables; ++t) rows += db->getTable("large" + to_string(t))->liveRowCount();
+    auto t4 = high_resolution_clock::now();
+
+    auto ms = [](auto d) { return duration_cast<microseconds>(d).count() / 1000.0; };
+    cout << fixed << setprecision(3);
+    cout << "File: " << filesystem::file_size(path) / (1024.0 * 1024.0) << " MB, "
+         << LargeTables + 1 << " tables, " << rows + 1 << " rows\n";
+    cout << "Load (directory only):      " << ms(t2 - t1) << " ms\n";
+    cout << "First query on small table: " << ms(t3 - t2) << " ms\n";
+    cout << "Materialize large tables:   " << ms(t4 - t3) << " ms\n";
+    filesystem::remove(path);
+    if (!found || rows != static_cast<std::size_t>(LargeTables) * RowsPerTable) {
+        cout << "Unexpected row count!\n";
+        return 1;
+    }
+    return 0;
+}
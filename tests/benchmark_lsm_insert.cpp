@@ -0,0 +1,69 @@
+// benchmark_lsm_insert.cpp
+// Benchmark comparing insert throughput of the default engine (row heap + BPlusTree index)
+// with the LSM engine (create_table ... engine=lsm), plus a point-lookup sanity check.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <algorithm>
+#include "../include/Table.h"
+#include "../include/Schema.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Records are built up front so only the engine's insert path is timed.
+static double insertAll(Table& table, const vector<int>& keys) {
+    vector<Record> records;
+    records.reserve(keys.size());
+    for (int key : keys) {
+        Record rec;
+        rec["id"] = key;
+        rec["value"] = "row_" + to_string(key);
+        records.push_back(std::move(rec));
+    }
+    auto t1 = high_resolution_clock::now();
+    for (auto& rec : records) table.insert(std::move(rec));
+    auto t2 = high_resolution_clock::now();
+    return duration_cast<duration<double>>(t2 - t1).count();
+}
+
+int main() {
+    vector<Column> columns = {
+        {"id", DataType::Integer},
+        {"value", DataType::String}
+    };
+
+    constexpr int N = 1000000;
+    vector<int> keys(N);
+    for (int i = 0; i < N; ++i) keys[i] = i;
+    shuffle(keys.begin(), keys.end(), mt19937(42));     // random key order: the B+tree's worst case
+
+    Table btree(TableSchema("btree_table", columns));
+    Table lsm(TableSchema("lsm_table", columns, TableEngine::Lsm));
+
+    double btreeSecs = insertAll(btree, keys);
+    double lsmSecs = insertAll(lsm, keys);
+
+    cout << fixed << setprecision(2);
+    cout << "Inserted " << N << " records in random key order\n";
+    cout << "BPlusTree engine: " << btreeSecs << " s (" << N / btreeSecs / 1e6 << " M rows/s)\n";
+    cout << "LSM engine:       " << lsmSecs << " s (" << N / lsmSecs / 1e6 << " M rows/s)\n";
+    cout << "Speedup: " << btreeSecs / lsmSecs << "x\n";
+
+    // Point lookups go through memtables and run files; both engines must agree.
+    mt19937 rng(7);
+    int mismatches = 0;
+    auto t1 = high_resolution_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        int key = keys[rng() % N];
+        auto a = btree.findByKey(Value(key));
+        auto b = lsm.findByKey(Value(key));
+        if (!a || !b || a->at("value") != b->at("value")) mismatches++;
+    }
+    auto t2 = high_resolution_clock::now();
+    cout << "1000 lookups on both engines: " << duration_cast<microseconds>(t2 - t1).count()
+         << " us, mismatches: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+// benchmark_string_keys.cpp
+// Benchmark for long string keys with shared prefixes (URL-like ids): BPlusTree inserts and point
+// lookups against std::map, then a table keyed on a composite (tenant, id) primary key.
+
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <algorithm>
+#include "../include/BPlusTree.h"
+#include "../include/Table.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+    constexpr int N = 500000;
+    vector<string> keys;
+    keys.reserve(N);
+    for (int i = 0; i < N; ++i) {
+        char id[16];
+        snprintf(id, sizeof id, "%09d", i * 7);
+        keys.push_back("https://shop.example.com/tenant-" + to_string(i % 50) + "/orders/2024/" + id);
+    }
+    vector<string> probes = keys;
+    shuffle(probes.begin(), probes.end(), mt19937(42));
+
+    BPlusTree<string, size_t> tree;
+    auto t1 = high_resolution_clock::now();
+    for (int i = 0; i < N; ++i) tree.insert(keys[i], i);
+    auto t2 = high_resolution_clock::now();
+    size_t treeSum = 0;
+    for (const auto& key : probes) treeSum += *tree.find(key);
+    auto t3 = high_resolution_clock::now();
+
+    map<string, size_t> ordered;
+    auto t4 = high_resolution_clock::now();
+    for (int i = 0; i < N; ++i) ordered.emplace(keys[i], i);
+    auto t5 = high_resolution_clock::now();
+    size_t mapSum = 0;
+    for (const auto& key : probes) mapSum += ordered.find(key)->second;
+    auto t6 = high_resolution_clock::now();
+
+    // Composite primary key: (tenant, id)
+    Table table(TableSchema("orders", {{"tenant", DataType::String}, {"id", DataType::Integer}, {"amount", DataType::Float}},
+                            TableEngine::BTree, {"tenant", "id"}));
+    constexpr int Rows = 200000;
+    auto t7 = high_resolution_clock::now();
+    for (int i = 0; i < Rows; ++i) {
+        Record rec;
+        rec["tenant"] = "tenant-" + to_string(i % 50);
+        rec["id"] = i / 50;
+        rec["amount"] = static_cast<float>(i % 100);
+        table.insert(std::move(rec));
+    }
+    auto t8 = high_resolution_clock::now();
+    int found = 0;
+    for (int i = 0; i < Rows; i += 7)
+        found += table.findByKey(vector<Value>{"tenant-" + to_string(i % 50), i / 50}).has_value();
+    auto t9 = high_resolution_clock::now();
+
+    auto ms = [](auto d) { return duration_cast<microseconds>(d).count() / 1000.0; };
+    cout << fixed << setprecision(3);
+    cout << "Keys: " << N << " (" << keys.front().size() << " bytes each, shared prefixes)\n";
+    cout << "BPlusTree insert: " << ms(t2 - t1) << " ms, lookups: " << ms(t3 - t2) << " ms (height " << tree.height() << ")\n";
+    cout << "std::map  insert: " << ms(t5 - t4) << " ms, lookups: " << ms(t6 - t5) << " ms\n";
+    cout << "Composite key table: " << Rows << " inserts " << ms(t8 - t7) << " ms, "
+         << found << " lookups " << ms(t9 - t8) << " ms\n";
+    if (treeSum != mapSum || found != (Rows + 6) / 7) {
+        cout << "Checksum mismatch!\n";
+        return 1;
+    }
+    return 0;
+}
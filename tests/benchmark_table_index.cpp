@@ -6,6 +6,7 @@
 #include <iostream>
 #include <chrono>
 #include <random>
+#include <iomanip>
 #include "../include/Table.h"
 #include "../include/Schema.h"
 
@@ -41,15 +42,16 @@ int main() {
 
     // ----- 3. Indexed find -----
     auto t1 = high_resolution_clock::now();
-    const Record* recIdx = table.findByKey(Value(probeKey));
+    auto recIdx = table.findByKey(Value(probeKey));
     auto t2 = high_resolution_clock::now();
     auto idxDur = duration_cast<nanoseconds>(t2-t1).count();
 
     // ----- 4. Linear scan find -----
-    // TO FORCE LINEAR SCAN: indexActive is private; simulate by iterating yourself
+    // TO FORCE LINEAR SCAN: indexActive is private; simulate by iterating a snapshot yourself
+    const auto snapshot = table.getRecords();
     t1 = high_resolution_clock::now();
     const Record* recLin = nullptr;
-    for (const auto& rec : table.getRecords()) {
+    for (const auto& rec : snapshot) {
         auto it = rec.find("id");
         if (it != rec.end() && std::holds_alternative<int>(it->second) && std::get<int>(it->second) == probeKey) {
             recLin = &rec;
@@ -88,12 +90,12 @@ int main() {
     // ----- 6. Bulk access benchmark -----
     t1 = high_resolution_clock::now();
     long long id_sum = 0;
-    for (const auto& rec : table.getRecords()) {
+    table.forEachRecord([&](const Record& rec) {
         auto it = rec.find("id");
         if (it != rec.end() && std::holds_alternative<int>(it->second)) {
             id_sum += std::get<int>(it->second);
         }
-    }
+    });
     t2 = high_resolution_clock::now();
     auto bulkDur = duration_cast<nanoseconds>(t2-t1).count();
     cout << "\nBulk access (sequential retrieval of all records) time: ";
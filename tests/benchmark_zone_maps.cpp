@@ -0,0 +1,64 @@
+// benchmark_zone_maps.cpp
+// Benchmark for zone-map scan skipping: range and equality filters on a clustered, unindexed
+// timestamp column against a full scan of every row, plus the same filter on an unclustered
+// column, where no segment can be skipped.
+
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include "../include/Table.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+    constexpr int N = 1000000;
+    Table table(TableSchema("events", {{"id", DataType::Integer}, {"ts", DataType::Integer}, {"amount", DataType::Integer}}));
+    mt19937 rng(42);
+    for (int i = 0; i < N; ++i) {
+        Record rec;
+        rec["id"] = i;
+        rec["ts"] = 1700000000 + i * 10 + static_cast<int>(rng() % 20);    // arrival order, slight jitter
+        rec["amount"] = static_cast<int>(rng() % 1000000);
+        table.insert(std::move(rec));
+    }
+
+    // One hour of events out of ~four months, and a similarly selective band of amounts.
+    ValueRange hour{1700000000 + 5000000, 1700000000 + 5000000 + 3600, true, false};
+    ValueRange band{500000, 500360, true, false};
+    auto ms = [](auto d) { return duration_cast<microseconds>(d).count() / 1000.0; };
+
+    const Value probeTs = table.findByKey(777777)->at("ts");
+
+    auto t1 = high_resolution_clock::now();
+    size_t fullScan = 0;
+    table.forEachRecord([&](const Record& rec) { fullScan += hour.contains(rec.at("ts")); });
+    auto t2 = high_resolution_clock::now();
+    size_t zoned = table.scanRange("ts", hour, [](const Record&) { return true; });
+    auto t3 = high_resolution_clock::now();
+    const auto tsStats = table.zoneMapStats();
+    size_t unclustered = table.scanRange("amount", band, [](const Record&) { return true; });
+    auto t4 = high_resolution_clock::now();
+    const auto amountStats = table.zoneMapStats();
+    auto probe = table.findFirst("ts", probeTs);
+    auto t5 = high_resolution_clock::now();
+    const auto probeStats = table.zoneMapStats();
+
+    cout << fixed << setprecision(3);
+    cout << "Rows: " << N << " in " << tsStats.blocksScanned + tsStats.blocksSkipped << " blocks of " << Table::kSegmentRows << "\n";
+    cout << "Full scan, ts in one hour:      " << ms(t2 - t1) << " ms (" << fullScan << " rows)\n";
+    cout << "Zone maps, ts in one hour:      " << ms(t3 - t2) << " ms (" << zoned << " rows, "
+         << tsStats.blocksSkipped << " blocks skipped, " << tsStats.blocksScanned << " scanned)\n";
+    cout << "Zone maps, amount band:         " << ms(t4 - t3) << " ms (" << unclustered << " rows, "
+         << amountStats.blocksSkipped - tsStats.blocksSkipped << " blocks skipped, "
+         << amountStats.blocksScanned - tsStats.blocksScanned << " scanned)\n";
+    cout << "findFirst ts=<value> (no index): " << ms(t5 - t4) << " ms (" << (probe ? "found" : "not found") << ", "
+         << probeStats.blocksSkipped - amountStats.blocksSkipped << " blocks skipped)\n";
+    cout << "ZONE MAP SPEEDUP (clustered range): " << ms(t2 - t1) / ms(t3 - t2) << "x\n";
+    if (zoned != fullScan) {
+        cout << "Row count mismatch!\n";
+        return 1;
+    }
+    return 0;
+}